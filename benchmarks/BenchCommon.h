@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include "VKBase+.h"
+
+using namespace vulkan;
+
+/**
+ * 不创建窗口和交换链，只创建实例和带图形队列的逻辑设备
+ * 优先选择CPU类型的物理设备（lavapipe），使各次运行的结果可相互比较
+ * pipelineCachePath：管线缓存文件的路径，为空字符串则不读写文件
+ */
+inline bool InitializeDevice(std::string pipelineCachePath = "") {
+    graphicsBase::Base().PipelineCachePath(std::move(pipelineCachePath));
+    if (graphicsBase::Base().CreateInstance() || graphicsBase::Base().GetPhysicalDevices()) { return false; }
+    uint32_t deviceIndex = 0;
+    for (uint32_t i = 0; i < graphicsBase::Base().AvailablePhysicalDeviceCount(); i++) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(graphicsBase::Base().AvailablePhysicalDevice(i), &properties);
+        if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+            deviceIndex = i;
+            break;
+        }
+    }
+    return !graphicsBase::Base().DeterminePhysicalDevice(deviceIndex, true, false) &&
+           !graphicsBase::Base().CreateDevice();
+}
+
+// 返回执行function所用的毫秒数
+template <typename F>
+double MeasureMilliseconds(F&& function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * 创建管线所需的对象：只有一个颜色附件的渲染通道、空的管线布局，以及FirstTriangle的两个着色器模块
+ * 须在逻辑设备销毁前析构，在main()中创建即可
+ */
+struct pipelineObjects {
+    renderPass colorPass;
+    pipelineLayout layout;
+    shaderModule vert;
+    shaderModule frag;
+
+    result_t Create() {
+        VkAttachmentDescription attachmentDescription = {
+            .format = VK_FORMAT_R8G8B8A8_UNORM,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        };
+        VkAttachmentReference attachmentReference = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        VkSubpassDescription subpassDescription = {
+            .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &attachmentReference,
+        };
+        VkRenderPassCreateInfo renderPassCreateInfo = {
+            .attachmentCount = 1,
+            .pAttachments = &attachmentDescription,
+            .subpassCount = 1,
+            .pSubpasses = &subpassDescription,
+        };
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        VkResult result;
+        false || (result = colorPass.Create(renderPassCreateInfo)) ||
+            (result = layout.Create(pipelineLayoutCreateInfo)) ||
+            (result = vert.Create(SHADER_DIR "FirstTriangle.vert.spv")) ||
+            (result = frag.Create(SHADER_DIR "FirstTriangle.frag.spv"));
+        return result;
+    }
+
+    // 第index个管线的创建信息，以颜色混合因子和写入掩码相区分，共15*15*15种，驱动须分别编译
+    graphicsPipelineCreateInfoPack CreateInfoPack(uint32_t index) const {
+        graphicsPipelineCreateInfoPack pipelineCiPack;
+        pipelineCiPack.createInfo.layout = layout;
+        pipelineCiPack.createInfo.renderPass = colorPass;
+        pipelineCiPack.inputAssemblyStateCi.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        pipelineCiPack.multisampleStateCi.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        // 不使用VK_BLEND_FACTOR_SRC1_COLOR及之后需要dualSrcBlend特性的因子
+        pipelineCiPack.colorBlendAttachmentStates.push_back({
+            .blendEnable = VK_TRUE,
+            .srcColorBlendFactor = static_cast<VkBlendFactor>(index % 15),
+            .dstColorBlendFactor = static_cast<VkBlendFactor>(index / 15 % 15),
+            .colorBlendOp = VK_BLEND_OP_ADD,
+            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+            .alphaBlendOp = VK_BLEND_OP_ADD,
+            .colorWriteMask = index / 225 % 15 + 1,
+        });
+        pipelineCiPack.shaderStages.push_back(vert.StageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT));
+        pipelineCiPack.shaderStages.push_back(frag.StageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT));
+        pipelineCiPack.UpdateAllArrays();
+        return pipelineCiPack;
+    }
+};
@@ -0,0 +1,54 @@
+// 比较逐对象独立分配（每个缓冲区一次vkAllocateMemory）与deviceMemoryAllocator子分配的吞吐量
+#include "BenchCommon.h"
+
+namespace {
+// 不超过Vulkan保证的maxMemoryAllocationCount最小值4096，独立分配也能全部成功
+constexpr uint32_t bufferCount = 4000;
+constexpr uint32_t roundCount = 5;
+
+// 返回创建全部缓冲区与销毁全部缓冲区各自所用的毫秒数，创建失败时返回负数
+std::pair<double, double> CreateAndDestroyBuffers(bool dedicated) {
+    std::vector<bufferMemory> buffers;
+    buffers.reserve(bufferCount);
+    bool failed = false;
+    double createTime = MeasureMilliseconds([&] {
+        for (uint32_t i = 0; i < bufferCount && !failed; i++) {
+            // 大小在256B到64KB之间变化，模拟各种网格和uniform缓冲区
+            VkBufferCreateInfo createInfo = {
+                .size = VkDeviceSize(256) << i % 9,
+                .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            };
+            if (buffers.emplace_back().Create(createInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dedicated)) {
+                failed = true;
+            }
+        }
+    });
+    double destroyTime = MeasureMilliseconds([&] { buffers.clear(); });
+    return failed ? std::pair(-1., -1.) : std::pair(createTime, destroyTime);
+}
+}  // namespace
+
+int main() {
+    if (!InitializeDevice()) { return 1; }
+    std::printf("%u buffers per round, best of %u rounds\n", bufferCount, roundCount);
+    for (bool dedicated : {true, false}) {
+        double bestCreateTime = INFINITY, bestDestroyTime = INFINITY;
+        for (uint32_t i = 0; i < roundCount; i++) {
+            auto [createTime, destroyTime] = CreateAndDestroyBuffers(dedicated);
+            if (createTime < 0) {
+                std::printf("Failed to create buffers (%s)\n", dedicated ? "dedicated" : "sub-allocated");
+                return 1;
+            }
+            bestCreateTime = std::min(bestCreateTime, createTime);
+            bestDestroyTime = std::min(bestDestroyTime, destroyTime);
+        }
+        std::printf(
+            "%-13s create: %8.2f ms (%9.0f buffers/s)  destroy: %8.2f ms\n",
+            dedicated ? "dedicated" : "sub-allocated", bestCreateTime, bufferCount / bestCreateTime * 1000,
+            bestDestroyTime
+        );
+    }
+    // 全部释放后每种内存类型仍保留一块，供此后的分配使用
+    std::printf("Memory blocks kept by deviceMemoryAllocator: %u\n", deviceMemoryAllocator::Get().BlockCount());
+    return 0;
+}
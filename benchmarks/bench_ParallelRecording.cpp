@@ -0,0 +1,88 @@
+// 以parallelRecorder在不同数量的线程中录制10万次绘制，比较录制所用的时间随线程数的变化
+// 只录制不提交，各帧的命令池在下一次BeginFrame(...)时重置
+#include "BenchCommon.h"
+
+namespace {
+constexpr uint32_t drawCount = 100'000;
+constexpr uint32_t roundCount = 5;
+constexpr VkExtent2D extent = {64, 64};
+}  // namespace
+
+int main() {
+    pipelineObjects objects;
+    imageMemory colorImage;
+    imageView colorView;
+    framebuffer framebuffer;
+    pipeline pipeline;
+    if (!InitializeDevice() || objects.Create()) { return 1; }
+
+    VkImageCreateInfo imageCreateInfo = {
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .extent = {extent.width, extent.height, 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+    };
+    VkImageSubresourceRange subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    graphicsPipelineCreateInfoPack pipelineCiPack = objects.CreateInfoPack(0);
+    VkResult result;
+    false || (result = colorImage.Create(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) ||
+        (result = colorView.Create(
+             colorImage.Image(), VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_R8G8B8A8_UNORM, subresourceRange
+         )) ||
+        (result = pipeline.Create(pipelineCiPack));
+    if (result) { return 1; }
+    VkFramebufferCreateInfo framebufferCreateInfo = {
+        .renderPass = objects.colorPass,
+        .attachmentCount = 1,
+        .pAttachments = colorView.Address(),
+        .width = extent.width,
+        .height = extent.height,
+        .layers = 1,
+    };
+    if (framebuffer.Create(framebufferCreateInfo)) { return 1; }
+
+    VkRect2D renderArea = {{}, extent};
+    VkClearValue clearColor = {};
+    VkCommandBufferInheritanceInfo inheritanceInfo = {
+        .renderPass = objects.colorPass,
+        .subpass = 0,
+        .framebuffer = framebuffer,
+    };
+    parallelRecorder::recordFunction record = [&](VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        for (uint32_t i = begin; i < end; i++) { vkCmdDraw(commandBuffer, 3, 1, 0, i); }
+    };
+    frameContext frameContext(graphicsBase::Base().QueueFamilyIndex_Graphics());
+
+    std::printf("%u draws per frame, best of %u frames\n", drawCount, roundCount);
+    double singleThreadTime = 0;
+    for (uint32_t threadCount = 1; threadCount <= std::max(std::thread::hardware_concurrency(), 1u);
+         threadCount *= 2) {
+        parallelRecorder recorder(threadCount);
+        double bestTime = INFINITY;
+        for (uint32_t round = 0; round < roundCount; round++) {
+            if (frameContext.BeginFrame(round) || recorder.BeginFrame(round)) { return 1; }
+            const commandBuffer* pCommandBuffer = frameContext.AcquireCommandBuffer();
+            if (!pCommandBuffer || pCommandBuffer->Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)) { return 1; }
+            objects.colorPass.CmdBegin(
+                *pCommandBuffer, framebuffer, renderArea, arrayRef<const VkClearValue>(clearColor),
+                VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+            );
+            double time = MeasureMilliseconds([&] {
+                recorder.Record(*pCommandBuffer, inheritanceInfo, renderArea, drawCount, record);
+            });
+            bestTime = std::min(bestTime, time);
+            renderPass::CmdEnd(*pCommandBuffer);
+            if (pCommandBuffer->End()) { return 1; }
+        }
+        if (threadCount == 1) { singleThreadTime = bestTime; }
+        std::printf(
+            "%2u thread(s): %8.2f ms (%6.2f M draws/s, speedup %.2fx)\n", threadCount, bestTime,
+            drawCount / bestTime / 1000, singleThreadTime / bestTime
+        );
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+// 比较管线缓存为空（冷启动）与从文件读入（热启动）时，从初始化设备到创建完全部管线所用的时间
+// 以cold为参数运行时先删除缓存文件，不带参数运行时使用上次写回的缓存文件
+#include "BenchCommon.h"
+
+namespace {
+constexpr const char* cachePath = "bench_pipelineCache.bin";
+constexpr uint32_t pipelineCount = 64;
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool cold = argc > 1 && !strcmp(argv[1], "cold");
+    if (cold) { std::remove(cachePath); }
+
+    // 创建逻辑设备时读入缓存文件，计入启动时间
+    bool initialized = false;
+    double deviceTime = MeasureMilliseconds([&] { initialized = InitializeDevice(cachePath); });
+    pipelineObjects objects;
+    if (!initialized || objects.Create()) { return 1; }
+
+    std::vector<pipeline> pipelines(pipelineCount);
+    bool failed = false;
+    double pipelineTime = MeasureMilliseconds([&] {
+        for (uint32_t i = 0; i < pipelineCount && !failed; i++) {
+            graphicsPipelineCreateInfoPack pipelineCiPack = objects.CreateInfoPack(i);
+            failed = pipelines[i].Create(pipelineCiPack);
+        }
+    });
+    // 写回缓存文件供下次热启动读取，在此显式调用以便写回失败时返回非0值
+    if (failed || graphicsBase::Base().SavePipelineCache()) { return 1; }
+
+    std::printf(
+        "%s cache: device %8.2f ms, %u pipelines %8.2f ms, total %8.2f ms\n", cold ? "cold" : "warm", deviceTime,
+        pipelineCount, pipelineTime, deviceTime + pipelineTime
+    );
+    return 0;
+}
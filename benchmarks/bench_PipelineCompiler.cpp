@@ -0,0 +1,39 @@
+// 以1、2、4、8个线程的pipelineCompiler创建N个管线，比较从提交到全部完成所用的时间
+#include "BenchCommon.h"
+
+namespace {
+constexpr uint32_t pipelineCount = 64;
+constexpr uint32_t threadCounts[] = {1, 2, 4, 8};
+}  // namespace
+
+int main() {
+    // 不读取缓存文件，但各轮共用graphicsBase的管线缓存，因此每轮创建不同的管线，以免命中前几轮的结果
+    pipelineObjects objects;
+    if (!InitializeDevice() || objects.Create()) { return 1; }
+
+    std::printf("%u pipelines per round, %u hardware threads\n", pipelineCount, std::thread::hardware_concurrency());
+    double singleThreadTime = 0;
+    for (uint32_t round = 0; round < std::size(threadCounts); round++) {
+        std::vector<graphicsPipelineCreateInfoPack> pipelineCiPacks;
+        for (uint32_t i = 0; i < pipelineCount; i++) {
+            pipelineCiPacks.push_back(objects.CreateInfoPack(round * pipelineCount + i));
+        }
+        pipelineCompiler compiler(threadCounts[round]);
+        std::vector<asyncPipeline> pipelines(pipelineCount);
+        bool failed = false;
+        double time = MeasureMilliseconds([&] {
+            for (uint32_t i = 0; i < pipelineCount; i++) { pipelines[i] = compiler.Compile(pipelineCiPacks[i]); }
+            for (auto& i : pipelines) { failed |= i.Wait() != VK_SUCCESS; }
+        });
+        if (failed) {
+            std::printf("Failed to create pipelines with %u thread(s)\n", threadCounts[round]);
+            return 1;
+        }
+        if (!round) { singleThreadTime = time; }
+        std::printf(
+            "%u thread(s): %8.2f ms (%6.2f pipelines/s, speedup %.2fx)\n", threadCounts[round], time,
+            pipelineCount / time * 1000, singleThreadTime / time
+        );
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+# 将SPIR-V二进制文件转换为内含constexpr uint32_t数组的头文件，在构建时调用：
+# cmake -DINPUT=<file.spv> -DOUTPUT=<file.h> -DSYMBOL=<数组名> -P EmbedSpirv.cmake
+cmake_minimum_required(VERSION 3.22)
+
+file(READ "${INPUT}" SPIRV_HEX HEX)
+string(LENGTH "${SPIRV_HEX}" SPIRV_HEX_LENGTH)
+math(EXPR SPIRV_SIZE "${SPIRV_HEX_LENGTH} / 2")
+math(EXPR SPIRV_REMAINDER "${SPIRV_SIZE} % 4")
+if(SPIRV_SIZE LESS 20 OR NOT SPIRV_REMAINDER EQUAL 0)
+    message(FATAL_ERROR "${INPUT} is not a valid SPIR-V binary (${SPIRV_SIZE} bytes)")
+endif()
+
+# SPIR-V按小端序存储，每4个字节重排为一个字
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1," SPIRV_WORDS "${SPIRV_HEX}")
+if(NOT SPIRV_WORDS MATCHES "^0x07230203,")
+    message(FATAL_ERROR "${INPUT} does not start with the SPIR-V magic number")
+endif()
+# 每行8个字，CMake的正则表达式不支持{n}，故将单个字的模式重复8次
+string(REPEAT "0x[0-9a-f]+," 8 EIGHT_WORDS)
+string(REGEX REPLACE "(${EIGHT_WORDS})" "\\1\n    " SPIRV_WORDS "${SPIRV_WORDS}")
+string(REPLACE "," ", " SPIRV_WORDS "${SPIRV_WORDS}")
+string(REPLACE " \n" "\n" SPIRV_WORDS "${SPIRV_WORDS}")
+string(STRIP "${SPIRV_WORDS}" SPIRV_WORDS)
+
+get_filename_component(INPUT_NAME "${INPUT}" NAME)
+file(WRITE "${OUTPUT}" "// 由cmake/EmbedSpirv.cmake根据${INPUT_NAME}生成，请勿手动修改
+#pragma once
+
+#include <cstdint>
+
+namespace embeddedShaders {
+
+inline constexpr uint32_t ${SYMBOL}[] = {
+    ${SPIRV_WORDS}
+};
+
+}  // namespace embeddedShaders
+")
@@ -1,19 +1,28 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <concepts>
+#include <condition_variable>
+#include <deque>
 #include <format>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <numbers>
 #include <numeric>
+#include <optional>
+#include <shared_mutex>
 #include <span>
 #include <sstream>
 #include <stack>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -33,6 +42,14 @@
 
 #include <vulkan/vulkan.h>
 
+// 内存映射文件，Windows下所需的windows.h已由vulkan.h包含
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 
 template <typename T>
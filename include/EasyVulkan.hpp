@@ -1,6 +1,7 @@
 #pragma once
 
-#include "VKBase+.h"
+#include "VKReflection.h"
+#include "VKFrameGraph.h"
 
 using namespace vulkan;
 inline const VkExtent2D& windowSize = graphicsBase::Base().SwapchainCreateInfo().imageExtent;
@@ -10,6 +10,7 @@ class graphicsBasePlus {
     commandPool commandPool_graphics{};
     commandPool commandPool_presentation{};
     commandPool commandPool_compute{};
+    commandPool commandPool_transfer{};  // 仅当存在独立的传输队列簇时创建
     commandBuffer commandBuffer_transfer{};  // 从commandPool_graphics分配
     commandBuffer commandBuffer_presentation{};
 
@@ -27,6 +28,12 @@ class graphicsBasePlus {
                     graphicsBase::Base().QueueFamilyIndex_Compute(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
                 );
             }
+            if (graphicsBase::Base().QueueFamilyIndex_Transfer() != VK_QUEUE_FAMILY_IGNORED &&
+                graphicsBase::Base().QueueFamilyIndex_Transfer() != graphicsBase::Base().QueueFamilyIndex_Graphics()) {
+                Singleton().commandPool_transfer.Create(
+                    graphicsBase::Base().QueueFamilyIndex_Transfer(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+                );
+            }
             if (graphicsBase::Base().QueueFamilyIndex_Presentation() != VK_QUEUE_FAMILY_IGNORED &&
                 graphicsBase::Base().QueueFamilyIndex_Presentation() !=
                     graphicsBase::Base().QueueFamilyIndex_Graphics() &&
@@ -48,6 +55,7 @@ class graphicsBasePlus {
             Singleton().commandPool_graphics.~commandPool();
             Singleton().commandPool_presentation.~commandPool();
             Singleton().commandPool_compute.~commandPool();
+            Singleton().commandPool_transfer.~commandPool();
         };
 
         graphicsBase::Plus(Singleton());
@@ -68,6 +76,10 @@ class graphicsBasePlus {
     // Getter
     const commandPool& CommandPool_Graphics() const { return commandPool_graphics; }
     const commandPool& CommandPool_Compute() const { return commandPool_compute; }
+    // 没有独立的传输队列簇时返回commandPool_graphics
+    const commandPool& CommandPool_Transfer() const {
+        return commandPool_transfer ? commandPool_transfer : commandPool_graphics;
+    }
     const commandBuffer& CommandBuffer_Transfer() const { return commandBuffer_transfer; }
 
     const VkFormatProperties& FormatProperties(VkFormat format) const {
@@ -91,6 +103,14 @@ class graphicsBasePlus {
         if (!result) { fence.Wait(); }
         return result;
     }
+    // 提交到传输队列并等待执行完毕，命令缓冲区应从CommandPool_Transfer()分配
+    static result_t ExecuteCommandBuffer_Transfer(VkCommandBuffer commandBuffer) {
+        fence fence;
+        VkSubmitInfo submitInfo = {.commandBufferCount = 1, .pCommandBuffers = &commandBuffer};
+        VkResult result = graphicsBase::Base().SubmitCommandBuffer_Transfer(submitInfo, fence);
+        if (!result) { fence.Wait(); }
+        return result;
+    }
 
     // 提交命令缓冲区到呈现队列，进行图像所有权转移
     // result_t AcquireImageOwnership_Presentation(VkSemaphore semaphore_renderingIsOver,
@@ -175,13 +195,14 @@ class stagingBuffer {
     void RetrieveData(void* pData_src, VkDeviceSize size) const { bufferMemory.RetrieveData(pData_src, size); }
     // Non-const function
     // 所分配设备内存大小不够时重新分配
+    // 使用独立分配，因为AliasedImage2D(...)要将图像绑定到整块内存的开头
     void Expand(VkDeviceSize size) {
         if (size <= bufferMemory.AllocationSize()) { return; }
         Release();
         VkBufferCreateInfo bufferCreateInfo = {
             .size = size, .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
         };
-        bufferMemory.Create(bufferCreateInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        bufferMemory.Create(bufferCreateInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
     }
     // 手动释放所有内存并销毁设备内存和缓冲区的handle
     void Release() { bufferMemory.~bufferMemory(); }
@@ -256,6 +277,471 @@ class stagingBuffer {
     }
 };
 
+/**
+ * 线程局部的传输上下文，使工作线程也能上传数据
+ * 每个线程独占暂存缓冲区、命令池、命令缓冲区和栅栏，录制命令无需任何全局锁，仅在提交时短暂锁定队列
+ * 在某线程中首次调用CurrentThread()时创建，线程结束时销毁；销毁逻辑设备时统一释放所有线程的上下文，
+ * 重建逻辑设备后，各上下文在其线程中下一次被使用时重新创建
+ */
+class transferContext {
+    static inline std::mutex mutex;
+    static inline std::vector<transferContext*> contexts;  // 所有存活的上下文
+    stagingBuffer stagingBuffer;
+    commandPool commandPool;
+    commandBuffer commandBuffer;
+    fence fence;
+    std::atomic_bool released = false;  // 由ReleaseAll()置位
+
+    transferContext() {
+        CreateCommandBuffer();
+        std::lock_guard lock(mutex);
+        contexts.push_back(this);
+    }
+    ~transferContext() {
+        std::lock_guard lock(mutex);
+        std::erase(contexts, this);
+    }
+    result_t CreateCommandBuffer() {
+        if (!VkCommandPool(commandPool)) {
+            VkResult result = commandPool.Create(
+                graphicsBase::Base().QueueFamilyIndex_Graphics(),
+                VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+            );
+            if (result) { return result; }
+        }
+        return commandPool.AllocateBuffers(arrayRef(commandBuffer));
+    }
+    // 若已被ReleaseAll()释放，重新创建栅栏、命令池和命令缓冲区（暂存缓冲区在写入数据时自动创建）
+    result_t RecreateIfReleased() {
+        if (!released.load(std::memory_order_acquire)) { return VK_SUCCESS; }
+        if (!VkFence(fence)) {
+            if (VkResult result = fence.Create()) { return result; }
+        }
+        if (VkResult result = CreateCommandBuffer()) { return result; }
+        released.store(false, std::memory_order_release);
+        return VK_SUCCESS;
+    }
+    static void ReleaseAll() {
+        std::lock_guard lock(mutex);
+        for (auto pContext : contexts) {
+            pContext->stagingBuffer.~stagingBuffer();
+            pContext->commandPool.~commandPool();
+            pContext->fence.~fence();
+            pContext->released.store(true, std::memory_order_release);
+        }
+    }
+    // 与stagingBuffer_mainThread相同，在静态初始化时注册回调，而非在首个调用CurrentThread()的线程中，
+    // 以免与其他线程对graphicsBase的回调列表的访问冲突
+    static inline bool callbackAdded = [] {
+        graphicsBase::Base().AddCallback_DestroyDevice(ReleaseAll);
+        return true;
+    }();
+
+  public:
+    transferContext(const transferContext&) = delete;
+    transferContext& operator=(const transferContext&) = delete;
+    // Getter
+    const vulkan::stagingBuffer& StagingBuffer() const { return stagingBuffer; }
+    const vulkan::commandBuffer& CommandBuffer() const { return commandBuffer; }
+    // Const function
+    // 提交CommandBuffer()中录制好的命令并等待其执行完毕
+    result_t ExecuteCommandBuffer() const {
+        VkResult result = graphicsBase::Base().SubmitCommandBuffer_Graphics(commandBuffer, fence);
+        result || (result = fence.WaitAndReset());
+        return result;
+    }
+    // Non-const function
+    // 经由本线程的暂存缓冲区将连续的数据块复制到buffer_dst，返回时复制已完成
+    result_t TransferData(VkBuffer buffer_dst, const void* pData_src, VkDeviceSize size, VkDeviceSize offset = 0) {
+        if (VkResult result = RecreateIfReleased()) { return result; }
+        stagingBuffer.BufferData(pData_src, size);
+        if (VkResult result = commandBuffer.Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)) { return result; }
+        VkBufferCopy region = {0, offset, size};
+        vkCmdCopyBuffer(commandBuffer, VkBuffer(stagingBuffer), buffer_dst, 1, &region);
+        if (VkResult result = commandBuffer.End()) { return result; }
+        return ExecuteCommandBuffer();
+    }
+    // 适用于不连续的多块数据，stride是每组数据间的步长
+    result_t TransferData(
+        VkBuffer buffer_dst, const void* pData_src, uint32_t elementCount, VkDeviceSize elementsSize,
+        VkDeviceSize stride_src, VkDeviceSize stride_dst, VkDeviceSize offset = 0
+    ) {
+        if (VkResult result = RecreateIfReleased()) { return result; }
+        stagingBuffer.BufferData(pData_src, stride_src * elementCount);
+        if (VkResult result = commandBuffer.Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)) { return result; }
+        auto regions = std::make_unique<VkBufferCopy[]>(elementCount);
+        for (size_t i = 0; i < elementCount; i++) {
+            regions[i] = {stride_src * i, stride_dst * i + offset, elementsSize};
+        }
+        vkCmdCopyBuffer(commandBuffer, VkBuffer(stagingBuffer), buffer_dst, elementCount, regions.get());
+        if (VkResult result = commandBuffer.End()) { return result; }
+        return ExecuteCommandBuffer();
+    }
+    // 向本线程的暂存缓冲区写入数据，之后可在CommandBuffer()中自行录制复制命令
+    void BufferData(const void* pData_src, VkDeviceSize size) { stagingBuffer.BufferData(pData_src, size); }
+    // Static function
+    // 取得本线程的上下文，逻辑设备被重建后会先重新创建其中被释放的对象
+    static transferContext& CurrentThread() {
+        thread_local transferContext context;
+        context.RecreateIfReleased();
+        return context;
+    }
+};
+
+/**
+ * 逐帧的暂存环，用于每帧的流式上传
+ * 每个飞行中的帧独占一段暂存内存，由该帧的栅栏保护；段不够用时按两倍扩容，
+ * 被替换的旧缓冲区可能仍在被GPU读取，留到该段下次被回收时才释放
+ * 稳定状态下既不等待设备空闲，也不重新分配内存
+ */
+class stagingRing {
+  public:
+    struct allocation {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void* pData = nullptr;  // 为nullptr说明分配失败
+    };
+    struct statistics {
+        VkDeviceSize highWaterMark = 0;  // 单帧用掉的暂存内存的最大值
+        uint32_t wrapCount = 0;          // 各段轮转一周、回到第0段的次数
+        uint32_t stallCount = 0;         // 回收某段时其栅栏尚未触发，不得不等待的次数
+        uint32_t growCount = 0;          // 段扩容的次数
+    };
+
+  private:
+    struct segment {
+        bufferMemory bufferMemory;
+        VkDeviceSize size = 0;
+        VkDeviceSize usedSize = 0;
+        std::vector<vulkan::bufferMemory> retiredBuffers;  // 扩容时被替换下来的缓冲区
+    };
+    segment segments[MAX_FRAMES_IN_FLIGHT];
+    uint32_t currentFrame = 0;
+    VkDeviceSize frameUsedSize = 0;  // 当前帧在各缓冲区（含扩容时被替换的）中用掉的总大小
+    statistics ringStatistics;
+
+    result_t Grow(segment& segment, VkDeviceSize minSize) {
+        VkBufferCreateInfo bufferCreateInfo = {
+            .size = std::max(segment.size * 2, minSize), .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+        };
+        // 旧缓冲区移入retiredBuffers，被移动后的对象析构一次以便重新创建
+        if (segment.bufferMemory.Buffer()) {
+            VkMappedMemoryRange range = {.offset = 0, .size = segment.usedSize};
+            segment.bufferMemory.FlushRanges(arrayRef(range));
+            segment.retiredBuffers.push_back(std::move(segment.bufferMemory));
+        }
+        segment.bufferMemory.~bufferMemory();
+        segment.size = segment.usedSize = 0;
+        VkResult result;
+        false || (result = segment.bufferMemory.Create(bufferCreateInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) ||
+            (result = segment.bufferMemory.PersistentlyMap());
+        if (result) { return result; }
+        segment.size = bufferCreateInfo.size;
+        segment.usedSize = 0;
+        ringStatistics.growCount++;
+        return VK_SUCCESS;
+    }
+
+  public:
+    stagingRing() = default;
+    explicit stagingRing(VkDeviceSize initialSizePerFrame) {
+        for (auto& i : segments) { Grow(i, initialSizePerFrame); }
+        ringStatistics.growCount = 0;
+    }
+    // Getter
+    const statistics& Statistics() const { return ringStatistics; }
+    uint32_t CurrentFrame() const { return currentFrame; }
+    VkDeviceSize UsedSize() const { return segments[currentFrame].usedSize; }
+    // Const function
+    // 非一致内存在提交前需flush当前段写入的范围
+    result_t Flush() const {
+        const segment& segment = segments[currentFrame];
+        VkMappedMemoryRange range = {.offset = 0, .size = segment.usedSize};
+        return segment.bufferMemory.FlushRanges(arrayRef(range));
+    }
+    // Non-const function
+    /**
+     * 等待并重置帧栅栏，栅栏尚未触发时计入stallCount，用以代替frameFence.WaitAndReset()
+     * 不得对已被重置、尚未再次提交的栅栏调用，否则会一直等待下去
+     */
+    result_t WaitAndReset(const fence& frameFence) {
+        VkResult result = frameFence.Status();
+        if (result == VK_NOT_READY) {
+            ringStatistics.stallCount++;
+            result = frameFence.Wait();
+        }
+        if (result) { return result; }
+        return frameFence.Reset();
+    }
+    // 开始新的一帧并回收该帧的段，调用前需确保该帧上一次提交的命令已执行完毕（即帧栅栏已被触发）
+    void BeginFrame(uint32_t frameIndex) {
+        frameIndex %= MAX_FRAMES_IN_FLIGHT;
+        if (frameIndex == 0 && frameIndex != currentFrame) { ringStatistics.wrapCount++; }
+        segment& segment = segments[frameIndex];
+        segment.retiredBuffers.clear();
+        segment.usedSize = 0;
+        frameUsedSize = 0;
+        currentFrame = frameIndex;
+    }
+    // 在当前帧的段中分配，alignment须为2的幂
+    allocation Allocate(VkDeviceSize size, VkDeviceSize alignment = 16) {
+        segment& segment = segments[currentFrame];
+        VkDeviceSize offset = segment.usedSize + alignment - 1 & ~(alignment - 1);
+        if (offset + size > segment.size) {
+            // 本帧已分配出去的部分仍要使用，旧缓冲区留待回收
+            if (Grow(segment, segment.usedSize + size)) { return {}; }
+            offset = 0;
+        }
+        frameUsedSize += offset + size - segment.usedSize;
+        segment.usedSize = offset + size;
+        ringStatistics.highWaterMark = std::max(ringStatistics.highWaterMark, frameUsedSize);
+        return {
+            segment.bufferMemory.Buffer(), offset, static_cast<uint8_t*>(segment.bufferMemory.MappedData()) + offset
+        };
+    }
+    // 写入数据并在commandBuffer中记录复制到dstBuffer的命令
+    result_t CmdCopyBuffer(
+        VkCommandBuffer commandBuffer, VkBuffer dstBuffer, const void* pData_src, VkDeviceSize size,
+        VkDeviceSize dstOffset = 0
+    ) {
+        allocation allocation = Allocate(size);
+        if (!allocation.pData) { return VK_RESULT_MAX_ENUM; }
+        memcpy(allocation.pData, pData_src, static_cast<size_t>(size));
+        VkBufferCopy region = {allocation.offset, dstOffset, size};
+        vkCmdCopyBuffer(commandBuffer, allocation.buffer, dstBuffer, 1, &region);
+        return VK_SUCCESS;
+    }
+};
+
+// 上传批次的等待凭据，在对应的uploadBatch被重置或析构前有效
+class uploadToken {
+    VkFence fence = VK_NULL_HANDLE;
+
+  public:
+    uploadToken() = default;
+    explicit uploadToken(VkFence fence) : fence(fence) {}
+    // Const function
+    bool IsComplete() const { return !fence || vkGetFenceStatus(graphicsBase::Base().Device(), fence) == VK_SUCCESS; }
+    result_t Wait() const {
+        if (!fence) { return VK_SUCCESS; }
+        VkResult result = vkWaitForFences(graphicsBase::Base().Device(), 1, &fence, false, UINT64_MAX);
+        if (result) {
+            outStream << std::format(
+                "[ uploadToken ] ERROR\nFailed to wait for the upload!\nError code: {}\n", static_cast<int32_t>(result)
+            );
+        }
+        return result;
+    }
+};
+
+/**
+ * 上传批次：将多次上传的数据依次写入持久映射的暂存内存，复制命令记录在同一个命令缓冲区中，
+ * Submit(...)时只提交一次并得到uploadToken，调用方等待该凭据前CPU不会阻塞
+ * 用法：若干次TransferData(...) -> Submit(...) -> 需要时Wait()，之后该批次可再次使用
+ * 提交失败时已录制的上传全部作废，批次被重置，可重新录制
+ */
+class uploadBatch {
+    struct chunk {
+        bufferMemory bufferMemory;
+        VkDeviceSize size = 0;
+        VkDeviceSize usedSize = 0;
+    };
+    commandPool commandPool;
+    commandBuffer commandBuffer;
+    fence fence;
+    std::vector<chunk> chunks;
+    size_t currentChunk = 0;
+    VkDeviceSize chunkSize = 0;
+    uint32_t copyCount = 0;
+    bool isRecording = false;
+    bool isSubmitted = false;
+
+    // 在暂存内存中分配，返回映射后的指针，失败时返回nullptr
+    void* AllocateStaging(VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset) {
+        // 对齐到16字节以满足任意格式的vkCmdCopyBufferToImage(...)对bufferOffset的要求
+        VkDeviceSize alignment = std::max<VkDeviceSize>(
+            16, graphicsBase::Base().PhysicalDeviceProperties().limits.optimalBufferCopyOffsetAlignment
+        );
+        for (; currentChunk < chunks.size(); currentChunk++) {
+            chunk& chunk = chunks[currentChunk];
+            VkDeviceSize alignedOffset = chunk.usedSize + alignment - 1 & ~(alignment - 1);
+            if (alignedOffset + size <= chunk.size) {
+                chunk.usedSize = alignedOffset + size;
+                buffer = chunk.bufferMemory.Buffer();
+                offset = alignedOffset;
+                return static_cast<uint8_t*>(chunk.bufferMemory.MappedData()) + alignedOffset;
+            }
+        }
+        // 现有的暂存内存均不够用，新建一块
+        VkBufferCreateInfo bufferCreateInfo = {
+            .size = std::max(size, chunkSize), .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+        };
+        chunk& chunk = chunks.emplace_back();
+        VkResult result;
+        false || (result = chunk.bufferMemory.Create(bufferCreateInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) ||
+            (result = chunk.bufferMemory.PersistentlyMap());
+        if (result) {
+            chunks.pop_back();
+            return nullptr;
+        }
+        chunk.size = bufferCreateInfo.size;
+        chunk.usedSize = size;
+        buffer = chunk.bufferMemory.Buffer();
+        offset = 0;
+        return chunk.bufferMemory.MappedData();
+    }
+
+    // 丢弃已录制的命令和暂存内存的占用，命令缓冲区须不在执行中
+    result_t Reset() {
+        for (auto& i : chunks) { i.usedSize = 0; }
+        currentChunk = 0;
+        copyCount = 0;
+        return commandPool.Reset();
+    }
+    // 若上一次提交尚未等待，先等待之，然后按需开始录制
+    result_t BeginRecording() {
+        if (isRecording) { return VK_SUCCESS; }
+        if (VkResult result = Wait()) { return result; }
+        if (VkResult result = commandBuffer.Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)) { return result; }
+        isRecording = true;
+        return VK_SUCCESS;
+    }
+
+  public:
+    explicit uploadBatch(VkDeviceSize chunkSize = 4ull << 20) : chunkSize(chunkSize) {
+        commandPool.Create(graphicsBase::Base().QueueFamilyIndex_Graphics(), VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        commandPool.AllocateBuffers(arrayRef(commandBuffer));
+    }
+    uploadBatch(uploadBatch&&) = delete;
+    ~uploadBatch() {
+        if (isSubmitted) { fence.Wait(); }
+    }
+    // Getter
+    uint32_t CopyCount() const { return copyCount; }
+    bool IsSubmitted() const { return isSubmitted; }
+    // Non-const function
+    // 将连续的数据块复制到dstBuffer的offset处
+    result_t TransferData(VkBuffer dstBuffer, const void* pData_src, VkDeviceSize size, VkDeviceSize offset = 0) {
+        if (VkResult result = BeginRecording()) { return result; }
+        VkBufferCopy region = {.dstOffset = offset, .size = size};
+        VkBuffer srcBuffer;
+        void* pData_dst = AllocateStaging(size, srcBuffer, region.srcOffset);
+        if (!pData_dst) { return VK_RESULT_MAX_ENUM; }
+        memcpy(pData_dst, pData_src, static_cast<size_t>(size));
+        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &region);
+        copyCount++;
+        return VK_SUCCESS;
+    }
+    // 将按stride_src排列的多块数据复制到dstBuffer中按stride_dst排列的位置，暂存内存中紧密排列
+    result_t TransferData(
+        VkBuffer dstBuffer, const void* pData_src, uint32_t elementCount, VkDeviceSize elementSize,
+        VkDeviceSize stride_src, VkDeviceSize stride_dst, VkDeviceSize offset = 0
+    ) {
+        if (VkResult result = BeginRecording()) { return result; }
+        VkBuffer srcBuffer;
+        VkDeviceSize srcOffset;
+        void* pData_dst = AllocateStaging(elementSize * elementCount, srcBuffer, srcOffset);
+        if (!pData_dst) { return VK_RESULT_MAX_ENUM; }
+        auto regions = std::make_unique<VkBufferCopy[]>(elementCount);
+        for (size_t i = 0; i < elementCount; i++) {
+            memcpy(
+                elementSize * i + static_cast<uint8_t*>(pData_dst),
+                stride_src * i + static_cast<const uint8_t*>(pData_src), static_cast<size_t>(elementSize)
+            );
+            regions[i] = {srcOffset + elementSize * i, stride_dst * i + offset, elementSize};
+        }
+        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, elementCount, regions.get());
+        copyCount++;
+        return VK_SUCCESS;
+    }
+    /**
+     * 将紧密排列的图像数据复制到image的一个mip级别，region.bufferOffset会被忽略
+     * 复制前图像从VK_IMAGE_LAYOUT_UNDEFINED转到VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL（原有内容被丢弃），
+     * 复制后转到layout_final，并使dstStage阶段的dstAccess操作可见
+     */
+    result_t TransferData_Image(
+        VkImage image, const void* pData_src, VkDeviceSize size, VkBufferImageCopy region,
+        VkImageLayout layout_final = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT
+    ) {
+        if (VkResult result = BeginRecording()) { return result; }
+        VkBuffer srcBuffer;
+        void* pData_dst = AllocateStaging(size, srcBuffer, region.bufferOffset);
+        if (!pData_dst) { return VK_RESULT_MAX_ENUM; }
+        memcpy(pData_dst, pData_src, static_cast<size_t>(size));
+        VkImageMemoryBarrier imageMemoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = {
+                region.imageSubresource.aspectMask, region.imageSubresource.mipLevel, 1,
+                region.imageSubresource.baseArrayLayer, region.imageSubresource.layerCount
+            }
+        };
+        vkCmdPipelineBarrier(
+            commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+            nullptr, 1, &imageMemoryBarrier
+        );
+        vkCmdCopyBufferToImage(commandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        if (layout_final != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            imageMemoryBarrier.dstAccessMask = dstAccess;
+            imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            imageMemoryBarrier.newLayout = layout_final;
+            vkCmdPipelineBarrier(
+                commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1,
+                &imageMemoryBarrier
+            );
+        }
+        copyCount++;
+        return VK_SUCCESS;
+    }
+    // 结束录制并一次性提交，成功时token为此次提交的凭据，没有录制任何命令时token为空凭据
+    result_t Submit(uploadToken& token) {
+        token = {};
+        if (!isRecording) { return VK_SUCCESS; }
+        // 非一致内存需flush写入的暂存数据
+        for (size_t i = 0; i <= currentChunk && i < chunks.size(); i++) {
+            VkMappedMemoryRange range = {.offset = 0, .size = chunks[i].usedSize};
+            chunks[i].bufferMemory.FlushRanges(arrayRef(range));
+        }
+        // 使此批次的所有写入对之后提交的命令可见
+        VkMemoryBarrier memoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+        };
+        vkCmdPipelineBarrier(
+            commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0,
+            nullptr, 0, nullptr
+        );
+        isRecording = false;
+        VkResult result = commandBuffer.End();
+        result || (result = graphicsBase::Base().SubmitCommandBuffer_Graphics(commandBuffer, fence));
+        if (result) {
+            // 未被提交的命令缓冲区不在执行中，可直接重置；返回先发生的错误，重置的结果在此被处理
+            static_cast<VkResult>(Reset());
+            return result;
+        }
+        isSubmitted = true;
+        token = uploadToken(fence);
+        return VK_SUCCESS;
+    }
+    // 等待已提交的批次执行完毕，然后重置以便再次使用（暂存内存保留）
+    result_t Wait() {
+        if (!isSubmitted) { return VK_SUCCESS; }
+        if (VkResult result = fence.WaitAndReset()) { return result; }
+        isSubmitted = false;
+        return Reset();
+    }
+};
+
 // 将具有VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT属性的缓冲区进行封装的类
 class deviceLocalBuffer {
   protected:
@@ -270,13 +756,14 @@ class deviceLocalBuffer {
     explicit operator VkBuffer() const { return bufferMemory.Buffer(); } // 显示转换函数
     const VkBuffer* Address() const { return bufferMemory.AddressOfBuffer(); }
     VkDeviceSize AllocateSize() const { return bufferMemory.AllocationSize(); }
+    bool IsPersistentlyMapped() const { return bufferMemory.IsPersistentlyMapped(); }
     // Const function
 
     // 适用于更新连续的数据块
-    void TransferData(const void* pData_src, VkDeviceSize size, VkDeviceSize offset = 0) const {
+    // 若缓冲区已持久映射，此函数只做memcpy（非一致内存另需flush）
+    result_t TransferData(const void* pData_src, VkDeviceSize size, VkDeviceSize offset = 0) const {
         if (bufferMemory.MemoryProperties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
-            bufferMemory.BufferData(pData_src, size, offset);
-            return;
+            return bufferMemory.BufferData(pData_src, size, offset);
         }
         /*
          * 具有VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT，但不具有VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT内存属性
@@ -284,49 +771,59 @@ class deviceLocalBuffer {
          * 1. 将数据写入暂存缓冲区
          * 2. 通过命令缓冲区将暂存缓冲区的数据复制到目标缓冲区
          * 3. 提交命令缓冲区并等待执行完成
+         * 使用当前线程的传输上下文，因而可在工作线程中调用
+         * 每次调用都单独提交并等待栅栏，更新多个缓冲区时应改用下方接受uploadBatch的重载，一并提交
          */
-        stagingBuffer::BufferData_MainThread(pData_src, size);
-        auto& commandBuffer = graphicsBase::Plus().CommandBuffer_Transfer();
-        commandBuffer.Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-        VkBufferCopy region = {0, offset, size};
-        vkCmdCopyBuffer(commandBuffer, stagingBuffer::Buffer_MianThread(), bufferMemory.Buffer(), 1, &region);
-        commandBuffer.End();
-        graphicsBase::Plus().ExecuteCommandBuffer_Graphics(commandBuffer);
+        return transferContext::CurrentThread().TransferData(bufferMemory.Buffer(), pData_src, size, offset);
     }
 
     // 适用于更新不连续的多块数据，stride是每组数据间的步长
-    void TransferData(
+    result_t TransferData(
         const void* pData_src, uint32_t elementCount, VkDeviceSize elementsSize, VkDeviceSize stride_src,
         VkDeviceSize stride_dst, VkDeviceSize offset = 0
     ) const {
         if (bufferMemory.MemoryProperties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
             void* pData_dst = nullptr;
-            bufferMemory.MapMemory(pData_dst, elementCount * stride_dst, offset);
+            if (VkResult result = bufferMemory.MapMemory(pData_dst, elementCount * stride_dst, offset)) {
+                return result;
+            }
             for (size_t i = 0; i < elementCount; i++) {
                 memcpy(
                     stride_dst * i + static_cast<uint8_t*>(pData_dst),
-                    stride_src * i + static_cast<const uint8_t*>(pData_src), static_cast<size_t>(elementCount)
+                    stride_src * i + static_cast<const uint8_t*>(pData_src), static_cast<size_t>(elementsSize)
                 );
             }
-            bufferMemory.UnmapMemory(elementCount * stride_dst, offset);
-            return;
+            return bufferMemory.UnmapMemory(elementCount * stride_dst, offset);
         }
-        stagingBuffer::BufferData_MainThread(pData_src, stride_src * elementCount);
-        auto& commandBuffer = graphicsBase::Plus().CommandBuffer_Transfer();
-        commandBuffer.Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-        auto regions = std::make_unique<VkBufferCopy[]>(elementCount);
-        for (size_t i = 0; i < elementCount; i++) {
-            regions[i] = {stride_src * i, stride_dst * i + offset, elementsSize};
-        }
-        vkCmdCopyBuffer(
-            commandBuffer, stagingBuffer::Buffer_MianThread(), bufferMemory.Buffer(), elementCount, regions.get()
+        return transferContext::CurrentThread().TransferData(
+            bufferMemory.Buffer(), pData_src, elementCount, elementsSize, stride_src, stride_dst, offset
         );
-        commandBuffer.End();
-        graphicsBase::Plus().ExecuteCommandBuffer_Graphics(commandBuffer);
     }
 
     // 适用于从缓冲区开头更新连续的数据块，数据大小自动判断
-    void TransferData(const auto& data_src) const { TransferData(&data_src, sizeof data_src); }
+    result_t TransferData(const auto& data_src) const { return TransferData(&data_src, sizeof data_src); }
+
+    // 以下重载将复制记录到uploadBatch中，不立即提交也不等待；host visible的缓冲区仍直接写入
+    result_t TransferData(uploadBatch& batch, const void* pData_src, VkDeviceSize size, VkDeviceSize offset = 0) const {
+        if (bufferMemory.MemoryProperties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            return bufferMemory.BufferData(pData_src, size, offset);
+        }
+        return batch.TransferData(bufferMemory.Buffer(), pData_src, size, offset);
+    }
+    result_t TransferData(
+        uploadBatch& batch, const void* pData_src, uint32_t elementCount, VkDeviceSize elementsSize,
+        VkDeviceSize stride_src, VkDeviceSize stride_dst, VkDeviceSize offset = 0
+    ) const {
+        if (bufferMemory.MemoryProperties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            return TransferData(pData_src, elementCount, elementsSize, stride_src, stride_dst, offset);
+        }
+        return batch.TransferData(
+            bufferMemory.Buffer(), pData_src, elementCount, elementsSize, stride_src, stride_dst, offset
+        );
+    }
+    result_t TransferData(uploadBatch& batch, const auto& data_src) const {
+        return TransferData(batch, &data_src, sizeof data_src);
+    }
 
     // vkCmdUpdateBuffer 将更新数据直接记录在commandBuffer中，它会影响commandBuffer大小
     void CmdUpdateBuffer(
@@ -354,11 +851,19 @@ class deviceLocalBuffer {
                 bufferMemory.AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) ||
             bufferMemory.BindMemory();
     }
+    // 可选：对host visible的缓冲区启用持久映射，适用于每帧更新的缓冲区，返回缓冲区是否已被持久映射
+    bool PersistentlyMap() {
+        if (!(bufferMemory.MemoryProperties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) { return false; }
+        VkResult result = bufferMemory.PersistentlyMap();
+        return !result;
+    }
     void Recreate(VkDeviceSize size, VkBufferUsageFlags desiredUsages_Without_transfer_dst) {
         // deviceLocalBuffer重建时需要确保GPU不再使用该缓冲区
         graphicsBase::Base().WaitIdle();
+        bool persistentlyMapped = IsPersistentlyMapped();
         bufferMemory.~bufferMemory();
         Create(size, desiredUsages_Without_transfer_dst);
+        if (persistentlyMapped) { PersistentlyMap(); }
     }
 };
 
@@ -430,9 +935,220 @@ class storageBuffer : public deviceLocalBuffer {
     }
 };
 
+/**
+ * 逐帧的线性环形分配器，用于每帧变化的uniform、storage、顶点数据
+ * 一个持久映射的缓冲区被均分为MAX_FRAMES_IN_FLIGHT段，每帧在自己的段内按对齐要求递增分配，
+ * 返回的偏移量可直接用作VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC的动态偏移
+ * 某帧的栅栏被触发后，调用BeginFrame(...)即可整段回收
+ */
+class frameRingBuffer {
+    bufferMemory bufferMemory;
+    VkDeviceSize segmentSize = 0;
+    VkDeviceSize usedSize = 0;  // 当前帧所在段已使用的大小
+    uint32_t currentFrame = 0;
+
+  public:
+    struct allocation {
+        void* pData = nullptr;  // 为nullptr说明当前帧的段已用尽
+        VkDeviceSize offset = 0;  // 相对于缓冲区开头的偏移
+    };
+
+    frameRingBuffer() = default;
+    frameRingBuffer(VkDeviceSize sizePerFrame, VkBufferUsageFlags usages) { Create(sizePerFrame, usages); }
+    // Getter
+    explicit operator VkBuffer() const { return bufferMemory.Buffer(); }
+    const VkBuffer* Address() const { return bufferMemory.AddressOfBuffer(); }
+    VkDeviceSize SegmentSize() const { return segmentSize; }
+    VkDeviceSize UsedSize() const { return usedSize; }
+    uint32_t CurrentFrame() const { return currentFrame; }
+    // Const function
+    // 非一致内存在提交前需flush当前帧写入的范围
+    result_t Flush() const {
+        VkMappedMemoryRange range = {.offset = segmentSize * currentFrame, .size = usedSize};
+        return bufferMemory.FlushRanges(arrayRef(range));
+    }
+    // Non-const function
+    // 开始新的一帧，调用前需确保该帧上一次提交的命令已执行完毕（即帧栅栏已被触发）
+    void BeginFrame(uint32_t frameIndex) {
+        currentFrame = frameIndex % MAX_FRAMES_IN_FLIGHT;
+        usedSize = 0;
+    }
+    // 在当前帧的段内分配，alignment须为2的幂
+    allocation Allocate(VkDeviceSize size, VkDeviceSize alignment = 1) {
+        VkDeviceSize offset = usedSize + alignment - 1 & ~(alignment - 1);
+        if (offset + size > segmentSize) {
+            outStream << std::format(
+                "[ frameRingBuffer ] ERROR\nRan out of the segment of the current frame!\nSegment size: {}\n",
+                segmentSize
+            );
+            return {};
+        }
+        usedSize = offset + size;
+        offset += segmentSize * currentFrame;
+        return {static_cast<uint8_t*>(bufferMemory.MappedData()) + offset, offset};
+    }
+    // CalculateAlignedSize(1)即为相应的最小偏移对齐
+    allocation Allocate_Uniform(VkDeviceSize size) { return Allocate(size, uniformBuffer::CalculateAlignedSize(1)); }
+    allocation Allocate_Storage(VkDeviceSize size) { return Allocate(size, storageBuffer::CalculateAlignedSize(1)); }
+    // 分配并写入数据，返回偏移量，当前帧的段已用尽时返回std::nullopt（偏移0属于第0帧的段，不能用作失败时的返回值）
+    std::optional<VkDeviceSize> Uniform(const void* pData_src, VkDeviceSize size) {
+        allocation allocation = Allocate_Uniform(size);
+        if (!allocation.pData) { return std::nullopt; }
+        memcpy(allocation.pData, pData_src, static_cast<size_t>(size));
+        return allocation.offset;
+    }
+    std::optional<VkDeviceSize> Uniform(const auto& data_src) { return Uniform(&data_src, sizeof data_src); }
+    void Create(VkDeviceSize sizePerFrame, VkBufferUsageFlags usages) {
+        // 每段的起始位置须同时满足uniform和storage缓冲区的偏移对齐要求
+        segmentSize = storageBuffer::CalculateAlignedSize(uniformBuffer::CalculateAlignedSize(sizePerFrame));
+        VkBufferCreateInfo bufferCreateInfo = {.size = segmentSize * MAX_FRAMES_IN_FLIGHT, .usage = usages};
+        false || bufferMemory.CreateBuffer(bufferCreateInfo) ||
+            bufferMemory.AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+                bufferMemory.AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ||
+            bufferMemory.BindMemory() || bufferMemory.PersistentlyMap();
+        usedSize = 0;
+    }
+};
+
+/**
+ * 可自动扩充的描述符分配器
+ * 持有一组描述符池，当前池耗尽时创建新池，每个新池可容纳的描述符集数量翻倍（不超过maxSetCountPerPool）
+ * poolSizeRatios中的descriptorCount为每个描述符集平均所需的该类描述符个数，乘以池可容纳的描述符集数量即为池的大小
+ * 描述符集不单独释放，调用Reset()一并回收所有池，须在销毁逻辑设备前销毁
+ */
+class descriptorAllocator {
+    static constexpr uint32_t maxSetCountPerPool = 4096;
+    std::vector<VkDescriptorPoolSize> poolSizeRatios;
+    std::vector<descriptorPool> readyPools;  // 可能还有余量的池，从最后一个中分配
+    std::vector<descriptorPool> fullPools;   // 已耗尽的池
+    uint32_t setCountPerPool = 0;
+    VkDescriptorPoolCreateFlags poolFlags = 0;
+
+    result_t CreatePool() {
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (auto& i : poolSizeRatios) {
+            poolSizes.emplace_back(i.type, std::max(i.descriptorCount * setCountPerPool, 1u));
+        }
+        descriptorPool pool;
+        VkResult result = pool.Create(setCountPerPool, arrayRef<const VkDescriptorPoolSize>(poolSizes), poolFlags);
+        if (result) { return result; }
+        readyPools.push_back(std::move(pool));
+        setCountPerPool = std::min(setCountPerPool * 2, maxSetCountPerPool);
+        return VK_SUCCESS;
+    }
+
+  public:
+    descriptorAllocator() = default;
+    descriptorAllocator(
+        arrayRef<const VkDescriptorPoolSize> poolSizeRatios, uint32_t initialSetCount = 64,
+        VkDescriptorPoolCreateFlags flags = 0
+    ) {
+        Create(poolSizeRatios, initialSetCount, flags);
+    }
+    descriptorAllocator(descriptorAllocator&&) = default;
+    // Getter
+    size_t PoolCount() const { return readyPools.size() + fullPools.size(); }
+    // Non-const function
+    result_t Allocate(arrayRef<VkDescriptorSet> sets, arrayRef<const VkDescriptorSetLayout> setLayouts) {
+        if (sets.Count() != setLayouts.Count()) {
+            outStream << std::format(
+                "[ descriptorAllocator ] ERROR\nFor each descriptor set, must provide a corresponding layout!\n"
+            );
+            return VK_RESULT_MAX_ENUM;
+        }
+        VkDescriptorSetAllocateInfo allocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorSetCount = static_cast<uint32_t>(sets.Count()),
+            .pSetLayouts = setLayouts.Pointer()
+        };
+        VkResult result = VK_SUCCESS;
+        // 当前池耗尽时换用新池重试一次，新池仍分配失败说明单次请求超出了池的容量
+        for (uint32_t attempt = 0; attempt < 2; attempt++) {
+            if (readyPools.empty()) {
+                if ((result = CreatePool())) { return result; }
+            }
+            allocateInfo.descriptorPool = readyPools.back();
+            result = vkAllocateDescriptorSets(graphicsBase::Base().Device(), &allocateInfo, sets.Pointer());
+            if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) { break; }
+            fullPools.push_back(std::move(readyPools.back()));
+            readyPools.pop_back();
+        }
+        if (result) {
+            outStream << std::format(
+                "[ descriptorAllocator ] ERROR\nFailed to allocate descriptor sets!\nError code: {}\n", int32_t(result)
+            );
+        }
+        return result;
+    }
+    result_t Allocate(arrayRef<VkDescriptorSet> sets, arrayRef<const descriptorSetLayout> setLayouts) {
+        return Allocate(sets, arrayRef<const VkDescriptorSetLayout>{setLayouts[0].Address(), setLayouts.Count()});
+    }
+    result_t Allocate(arrayRef<descriptorSet> sets, arrayRef<const VkDescriptorSetLayout> setLayouts) {
+        return Allocate(arrayRef<VkDescriptorSet>{&sets[0].handle, sets.Count()}, setLayouts);
+    }
+    result_t Allocate(arrayRef<descriptorSet> sets, arrayRef<const descriptorSetLayout> setLayouts) {
+        return Allocate(
+            arrayRef<VkDescriptorSet>{&sets[0].handle, sets.Count()},
+            arrayRef<const VkDescriptorSetLayout>{setLayouts[0].Address(), setLayouts.Count()}
+        );
+    }
+    // 回收所有池中的描述符集，保留池以供复用，调用前需确保这些描述符集不再被任何执行中的命令使用
+    result_t Reset() {
+        for (auto& i : fullPools) { readyPools.push_back(std::move(i)); }
+        fullPools.clear();
+        for (auto& i : readyPools) {
+            if (VkResult result = i.Reset()) { return result; }
+        }
+        return VK_SUCCESS;
+    }
+    void Create(
+        arrayRef<const VkDescriptorPoolSize> poolSizeRatios, uint32_t initialSetCount = 64,
+        VkDescriptorPoolCreateFlags flags = 0
+    ) {
+        this->poolSizeRatios.assign(poolSizeRatios.begin(), poolSizeRatios.end());
+        readyPools.clear();
+        fullPools.clear();
+        setCountPerPool = std::clamp(initialSetCount, 1u, maxSetCountPerPool);
+        poolFlags = flags;
+    }
+};
+
+/**
+ * 逐帧的描述符分配器，每帧各有一个descriptorAllocator，用于只在一帧内使用的临时描述符集
+ * 某帧的栅栏被触发后，调用BeginFrame(...)即可用vkResetDescriptorPool整体回收该帧的描述符集，无需逐个释放
+ */
+class frameDescriptorAllocator {
+    std::array<descriptorAllocator, MAX_FRAMES_IN_FLIGHT> allocators;
+    uint32_t currentFrame = 0;
+
+  public:
+    frameDescriptorAllocator() = default;
+    frameDescriptorAllocator(arrayRef<const VkDescriptorPoolSize> poolSizeRatios, uint32_t initialSetCount = 64) {
+        Create(poolSizeRatios, initialSetCount);
+    }
+    // Getter
+    uint32_t CurrentFrame() const { return currentFrame; }
+    descriptorAllocator& Current() { return allocators[currentFrame]; }
+    // Non-const function
+    // 开始新的一帧，调用前需确保该帧上一次提交的命令已执行完毕（即帧栅栏已被触发）
+    result_t BeginFrame(uint32_t frameIndex) {
+        currentFrame = frameIndex % MAX_FRAMES_IN_FLIGHT;
+        return allocators[currentFrame].Reset();
+    }
+    template <typename T, typename U>
+    result_t Allocate(arrayRef<T> sets, arrayRef<const U> setLayouts) {
+        return allocators[currentFrame].Allocate(sets, setLayouts);
+    }
+    void Create(arrayRef<const VkDescriptorPoolSize> poolSizeRatios, uint32_t initialSetCount = 64) {
+        for (auto& i : allocators) { i.Create(poolSizeRatios, initialSetCount); }
+    }
+};
+
 struct graphicsPipelineCreateInfoPack {
     VkGraphicsPipelineCreateInfo createInfo = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
     std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+    // 与shaderStages按索引对应，非空者在更新数组地址时写入相应阶段的pSpecializationInfo，复制创建信息包时一并复制
+    std::vector<specializationInfo> specializationInfos;
 
     /**
      * Vertex input
@@ -464,6 +1180,8 @@ struct graphicsPipelineCreateInfoPack {
     /**
      * Viewport
      * 视口状态用于指定视口和裁剪范围
+     * 默认视口和裁剪范围均为动态状态（见dynamicStates），viewports和scissors留空即可，
+     * 由renderPass::CmdBegin(...)按渲染区域设置，窗口大小改变时无需重建管线
      */
     VkPipelineViewportStateCreateInfo viewportStateCi = {VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
     std::vector<VkViewport> viewports;
@@ -494,7 +1212,7 @@ struct graphicsPipelineCreateInfoPack {
 
     // Dynamic
     VkPipelineDynamicStateCreateInfo dynamicStateCi = {VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
-    std::vector<VkDynamicState> dynamicStates;
+    std::vector<VkDynamicState> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
 
     //------------------------------------------
 
@@ -502,6 +1220,7 @@ struct graphicsPipelineCreateInfoPack {
         SetCreateInfos();
         // 若非派生管线，createInfo.basePipelineIndex不得为，设置为-1
         createInfo.basePipelineIndex = -1;
+        UpdateAllArrays();
     }
 
     // 移动构造器，所有指针都要重新赋值
@@ -520,6 +1239,7 @@ struct graphicsPipelineCreateInfoPack {
         dynamicStateCi = other.dynamicStateCi;
 
         shaderStages = other.shaderStages;
+        specializationInfos = other.specializationInfos;
         vertexInputBindings = other.vertexInputBindings;
         vertexInputAttributes = other.vertexInputAttributes;
         viewports = other.viewports;
@@ -532,6 +1252,13 @@ struct graphicsPipelineCreateInfoPack {
     // Getter
     operator VkGraphicsPipelineCreateInfo&() { return createInfo; }
 
+    // 添加着色器阶段及其特化常量，特化常量由创建信息包持有
+    void AddShaderStage(const VkPipelineShaderStageCreateInfo& stage, specializationInfo specialization = {}) {
+        specializationInfos.resize(shaderStages.size());
+        shaderStages.push_back(stage);
+        specializationInfos.push_back(std::move(specialization));
+    }
+
     // 将各个数组的地址更新到createInfo中，并更新各个数组的count
     void UpdateAllArrays() {
         createInfo.stageCount = shaderStages.size();
@@ -562,6 +1289,11 @@ struct graphicsPipelineCreateInfoPack {
     // 将所有数组的地址更新到createInfo中，但不改变各个数组的count
     void UpdateAllArrayAddresses() {
         createInfo.pStages = shaderStages.data();
+        for (size_t i = 0; i < std::min(shaderStages.size(), specializationInfos.size()); i++) {
+            if (!specializationInfos[i].Empty()) {
+                shaderStages[i].pSpecializationInfo = specializationInfos[i].Address();
+            }
+        }
         vertexInputStateCi.pVertexBindingDescriptions = vertexInputBindings.data();
         vertexInputStateCi.pVertexAttributeDescriptions = vertexInputAttributes.data();
         viewportStateCi.pViewports = viewports.data();
@@ -570,4 +1302,1472 @@ struct graphicsPipelineCreateInfoPack {
         dynamicStateCi.pDynamicStates = dynamicStates.data();
     }
 };
-}  // namespace vulkan
\ No newline at end of file
+
+// 异步编译的管线，由pipelineCompiler返回，可复制，所有副本共享同一管线
+class asyncPipeline {
+    friend class pipelineCompiler;
+    struct state {
+        pipeline pipeline;
+        VkResult result = VK_SUCCESS;
+        std::atomic<bool> ready = false;
+    };
+    std::shared_ptr<state> pState;
+
+  public:
+    asyncPipeline() = default;
+    // Getter
+    bool IsReady() const { return pState && pState->ready.load(std::memory_order_acquire); }
+    // 编译完成前返回VK_NOT_READY
+    VkResult Result() const { return IsReady() ? pState->result : VK_NOT_READY; }
+    // 编译成功则返回所编译的管线，否则返回后备管线，供渲染循环在编译完成前先行绘制
+    VkPipeline Get(VkPipeline fallback = VK_NULL_HANDLE) const {
+        return IsReady() && !pState->result ? static_cast<VkPipeline>(pState->pipeline) : fallback;
+    }
+    // Const function
+    // 阻塞直至编译完成
+    VkResult Wait() const {
+        if (!pState) { return VK_NOT_READY; }
+        pState->ready.wait(false, std::memory_order_acquire);
+        return pState->result;
+    }
+};
+
+/**
+ * 管线编译服务
+ * 在工作线程池中创建图形和计算管线，共用graphicsBase的管线缓存（管线缓存本身是线程安全的）
+ * 图形管线的创建信息包会被复制，着色器阶段须放在shaderStages中，specializationInfos中的特化常量随之复制；
+ * 着色器模块、其他方式指定的特化常量等被指向的数据须在编译完成前保持有效
+ * 须在销毁逻辑设备前销毁，析构时会先编译完所有已提交的任务
+ */
+class pipelineCompiler {
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+
+    void Work() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(mutex);
+                condition.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) { return; }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+    template <typename T>
+    asyncPipeline Enqueue(T&& createInfo) {
+        asyncPipeline handle;
+        handle.pState = std::make_shared<asyncPipeline::state>();
+        {
+            std::lock_guard lock(mutex);
+            jobs.emplace_back([pState = handle.pState, createInfo = std::forward<T>(createInfo)]() mutable {
+                // result_t在此处被处理，不会因错误未处理而抛出异常
+                VkResult result = pState->pipeline.Create(createInfo);
+                pState->result = result;
+                pState->ready.store(true, std::memory_order_release);
+                pState->ready.notify_all();
+            });
+        }
+        condition.notify_one();
+        return handle;
+    }
+
+  public:
+    explicit pipelineCompiler(uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u)) {
+        for (uint32_t i = 0; i < threadCount; i++) { workers.emplace_back(&pipelineCompiler::Work, this); }
+    }
+    pipelineCompiler(pipelineCompiler&&) = delete;
+    ~pipelineCompiler() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (auto& i : workers) { i.join(); }
+    }
+    // Getter
+    uint32_t ThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+    // Non-const function
+    asyncPipeline Compile(const graphicsPipelineCreateInfoPack& createInfoPack) {
+        graphicsPipelineCreateInfoPack pack = createInfoPack;
+        pack.UpdateAllArrays();
+        return Enqueue(std::move(pack));
+    }
+    asyncPipeline Compile(const VkComputePipelineCreateInfo& createInfo) { return Enqueue(createInfo); }
+};
+
+// 64位FNV-1a，结果与平台和运行次数无关，用作各缓存的键的哈希
+inline uint64_t Hash(std::string_view data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char i : data) { hash = (hash ^ i) * 1099511628211ull; }
+    return hash;
+}
+
+// 只读的内存映射文件
+class mappedFile {
+    const void* pData = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE mapping = nullptr;
+#endif
+
+  public:
+    mappedFile() = default;
+    explicit mappedFile(const char* filepath) { Open(filepath); }
+    mappedFile(mappedFile&& other) noexcept {
+        pData = std::exchange(other.pData, nullptr);
+        size = std::exchange(other.size, 0);
+#ifdef _WIN32
+        mapping = std::exchange(other.mapping, nullptr);
+#endif
+    }
+    ~mappedFile() { Close(); }
+    // Getter
+    const void* Data() const { return pData; }
+    size_t Size() const { return size; }
+    explicit operator bool() const { return pData; }
+    // Non-const function
+    // 映射整个文件，文件不存在或为空时返回false
+    bool Open(const char* filepath) {
+        Close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(
+            filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+        );
+        if (file == INVALID_HANDLE_VALUE) { return false; }
+        LARGE_INTEGER fileSize = {};
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        CloseHandle(file);
+        if (!mapping) { return false; }
+        if (!(pData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return false;
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int file = open(filepath, O_RDONLY);
+        if (file < 0) { return false; }
+        struct stat fileStatus = {};
+        if (!fstat(file, &fileStatus) && fileStatus.st_size > 0) {
+            void* pMapped = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if (pMapped != MAP_FAILED) {
+                pData = pMapped;
+                size = static_cast<size_t>(fileStatus.st_size);
+            }
+        }
+        // 映射建立后即可关闭文件描述符
+        close(file);
+#endif
+        return pData;
+    }
+    void Close() {
+        if (!pData) { return; }
+#ifdef _WIN32
+        UnmapViewOfFile(pData);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(const_cast<void*>(pData), size);
+#endif
+        pData = nullptr;
+        size = 0;
+    }
+};
+
+/**
+ * 着色器模块缓存
+ * 以内存映射读取SPIR-V文件并校验，按内容哈希去重：同一路径第二次加载不再读文件，不同路径下内容相同的文件共用一个模块
+ * 返回共享的模块，在所有用到模块的管线创建完后调用ReleaseUnused()，释放仅被缓存持有的模块
+ * 销毁逻辑设备时自动清空，外部持有的模块须在此之前释放
+ */
+class shaderModuleCache {
+    std::unordered_map<std::string, uint64_t> hashesByPath;  // 文件路径 -> 内容哈希
+    std::unordered_map<uint64_t, std::shared_ptr<const shaderModule>> modules;  // 内容哈希 -> 模块
+    std::unordered_map<VkShaderModule, uint64_t> hashesByModule;               // 由本缓存创建的模块 -> 内容哈希
+    mutable std::mutex mutex;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+
+    // 由graphicsBase持有，见graphicsBase::OwnedSingleton()
+    friend class graphicsBase;
+    shaderModuleCache() {
+        graphicsBase::Base().AddCallback_DestroyDevice([] {
+            graphicsBase::OwnedSingleton<shaderModuleCache>().Clear();
+        });
+    }
+    // 检查SPIR-V的大小、对齐和魔数，魔数字节序相反说明字节序不符
+    static bool Validate(const void* pCode, size_t codeSize, const char* name) {
+        static constexpr uint32_t spirvMagicNumber = 0x07230203;
+        // SPIR-V头部有5个字
+        if (codeSize < 20 || codeSize % 4 || reinterpret_cast<uintptr_t>(pCode) % 4) {
+            outStream << std::format(
+                "[ shaderModuleCache ] ERROR\nInvalid SPIR-V size or alignment: {}, {} bytes\n", name, codeSize
+            );
+            return false;
+        }
+        if (*static_cast<const uint32_t*>(pCode) != spirvMagicNumber) {
+            outStream << std::format("[ shaderModuleCache ] ERROR\nInvalid SPIR-V magic number: {}\n", name);
+            return false;
+        }
+        return true;
+    }
+    // 调用前须锁定mutex
+    std::shared_ptr<const shaderModule> FindOrCreate(uint64_t hash, size_t codeSize, const uint32_t* pCode) {
+        if (auto iterator = modules.find(hash); iterator != modules.end()) {
+            hitCount++;
+            return iterator->second;
+        }
+        missCount++;
+        auto pModule = std::make_shared<shaderModule>();
+        if (VkResult result = pModule->Create(codeSize, pCode)) { return {}; }
+        hashesByModule.emplace(static_cast<VkShaderModule>(*pModule), hash);
+        return modules.emplace(hash, std::move(pModule)).first->second;
+    }
+
+  public:
+    shaderModuleCache(shaderModuleCache&&) = delete;
+    // Getter
+    uint64_t HitCount() const {
+        std::lock_guard lock(mutex);
+        return hitCount;
+    }
+    uint64_t MissCount() const {
+        std::lock_guard lock(mutex);
+        return missCount;
+    }
+    size_t Size() const {
+        std::lock_guard lock(mutex);
+        return modules.size();
+    }
+    // 取得由本缓存创建的模块的内容哈希，其他模块返回std::nullopt
+    std::optional<uint64_t> CodeHash(VkShaderModule module) const {
+        std::lock_guard lock(mutex);
+        auto iterator = hashesByModule.find(module);
+        return iterator == hashesByModule.end() ? std::nullopt : std::optional(iterator->second);
+    }
+    // Non-const function
+    // 失败时返回空指针
+    std::shared_ptr<const shaderModule> Load(const char* filepath) {
+        std::lock_guard lock(mutex);
+        if (auto iterator = hashesByPath.find(filepath); iterator != hashesByPath.end()) {
+            if (auto module = modules.find(iterator->second); module != modules.end()) {
+                hitCount++;
+                return module->second;
+            }
+        }
+        mappedFile file(filepath);
+        if (!file) {
+            outStream << std::format("[ shaderModuleCache ] ERROR\nFailed to map the file: {}\n", filepath);
+            return {};
+        }
+        if (!Validate(file.Data(), file.Size(), filepath)) { return {}; }
+        uint64_t hash = Hash({static_cast<const char*>(file.Data()), file.Size()});
+        hashesByPath[filepath] = hash;
+        return FindOrCreate(hash, file.Size(), static_cast<const uint32_t*>(file.Data()));
+    }
+    std::shared_ptr<const shaderModule> Load(size_t codeSize, const uint32_t* pCode) {
+        if (!Validate(pCode, codeSize, "(memory)")) { return {}; }
+        std::lock_guard lock(mutex);
+        return FindOrCreate(Hash({reinterpret_cast<const char*>(pCode), codeSize}), codeSize, pCode);
+    }
+    // 释放仅被缓存持有的模块，已创建的管线不依赖着色器模块
+    void ReleaseUnused() {
+        std::lock_guard lock(mutex);
+        std::erase_if(modules, [this](const auto& i) {
+            if (i.second.use_count() > 1) { return false; }
+            hashesByModule.erase(static_cast<VkShaderModule>(*i.second));
+            return true;
+        });
+    }
+    void Clear() {
+        std::lock_guard lock(mutex);
+        modules.clear();
+        hashesByModule.clear();
+        hashesByPath.clear();
+    }
+    // Static function
+    static shaderModuleCache& Get() { return graphicsBase::OwnedSingleton<shaderModuleCache>(); }
+};
+
+/**
+ * 描述符集布局与管线布局的缓存，内容相同的布局只创建一次并被共享，因而由同一缓存得到的布局天然兼容
+ * 描述符集布局以规范化后的绑定为键：按binding排序，计入创建标志、各绑定的标志及不可变采样器（仅对采样器类型有效）
+ * 管线布局以各描述符集布局的键（非本缓存创建的则为handle）及排序后的push constant范围为键
+ * 销毁逻辑设备时自动清空，外部持有的布局须在此之前释放
+ */
+class layoutCache {
+    struct keyHash {
+        size_t operator()(const std::string& key) const { return static_cast<size_t>(Hash(key)); }
+    };
+    std::unordered_map<std::string, std::shared_ptr<const descriptorSetLayout>, keyHash> descriptorSetLayouts;
+    std::unordered_map<VkDescriptorSetLayout, std::string> keysBySetLayout;  // 由本缓存创建的描述符集布局 -> 键
+    std::unordered_map<std::string, std::shared_ptr<const pipelineLayout>, keyHash> pipelineLayouts;
+    std::unordered_map<VkPipelineLayout, std::string> keysByPipelineLayout;  // 由本缓存创建的管线布局 -> 键
+    mutable std::mutex mutex;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+
+    // 由graphicsBase持有，见graphicsBase::OwnedSingleton()
+    friend class graphicsBase;
+    layoutCache() {
+        graphicsBase::Base().AddCallback_DestroyDevice([] { graphicsBase::OwnedSingleton<layoutCache>().Clear(); });
+    }
+    template <typename... T>
+    static void Append(std::string& key, const T&... values) {
+        (key.append(reinterpret_cast<const char*>(&values), sizeof values), ...);
+    }
+    static bool UsesImmutableSamplers(VkDescriptorType type) {
+        return type == VK_DESCRIPTOR_TYPE_SAMPLER || type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    }
+    template <typename T>
+    std::shared_ptr<const T> Find(
+        const std::unordered_map<std::string, std::shared_ptr<const T>, keyHash>& layouts, const std::string& key
+    ) {
+        auto iterator = layouts.find(key);
+        if (iterator == layouts.end()) {
+            missCount++;
+            return {};
+        }
+        hitCount++;
+        return iterator->second;
+    }
+
+  public:
+    layoutCache(layoutCache&&) = delete;
+    // Getter
+    uint64_t HitCount() const {
+        std::lock_guard lock(mutex);
+        return hitCount;
+    }
+    uint64_t MissCount() const {
+        std::lock_guard lock(mutex);
+        return missCount;
+    }
+    size_t DescriptorSetLayoutCount() const {
+        std::lock_guard lock(mutex);
+        return descriptorSetLayouts.size();
+    }
+    size_t PipelineLayoutCount() const {
+        std::lock_guard lock(mutex);
+        return pipelineLayouts.size();
+    }
+    // 取得由本缓存创建的管线布局的键，其他布局返回std::nullopt
+    std::optional<std::string> PipelineLayoutKey(VkPipelineLayout layout) const {
+        std::lock_guard lock(mutex);
+        auto iterator = keysByPipelineLayout.find(layout);
+        return iterator == keysByPipelineLayout.end() ? std::nullopt : std::optional(iterator->second);
+    }
+    // Non-const function
+    /**
+     * 取得具有给定绑定的描述符集布局，绑定的顺序不影响结果，创建失败时返回空指针
+     * bindingFlags为空或与bindings一一对应，有非0的标志时经VkDescriptorSetLayoutBindingFlagsCreateInfo（Vulkan 1.2）指定
+     */
+    std::shared_ptr<const descriptorSetLayout> DescriptorSetLayout(
+        arrayRef<const VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags = 0,
+        arrayRef<const VkDescriptorBindingFlags> bindingFlags = {}
+    ) {
+        if (bindingFlags.Count() && bindingFlags.Count() != bindings.Count()) {
+            outStream << std::format("[ layoutCache ] ERROR\nFor each binding, must provide corresponding flags!\n");
+            return {};
+        }
+        std::vector<uint32_t> order(bindings.Count());
+        std::iota(order.begin(), order.end(), 0);
+        std::ranges::sort(order, {}, [&](uint32_t i) { return bindings[i].binding; });
+        std::vector<VkDescriptorSetLayoutBinding> sortedBindings;
+        std::vector<VkDescriptorBindingFlags> sortedBindingFlags;
+        std::string key;
+        Append(key, flags, bindings.Count());
+        for (uint32_t i : order) {
+            VkDescriptorSetLayoutBinding& binding = sortedBindings.emplace_back(bindings[i]);
+            VkDescriptorBindingFlags bindingFlag = bindingFlags.Count() ? bindingFlags[i] : 0;
+            sortedBindingFlags.push_back(bindingFlag);
+            // 非采样器类型的pImmutableSamplers会被忽略，不应影响键
+            if (!UsesImmutableSamplers(binding.descriptorType)) { binding.pImmutableSamplers = nullptr; }
+            Append(
+                key, binding.binding, binding.descriptorType, binding.descriptorCount, binding.stageFlags, bindingFlag,
+                bool(binding.pImmutableSamplers)
+            );
+            if (binding.pImmutableSamplers) {
+                auto pSamplers = reinterpret_cast<const char*>(binding.pImmutableSamplers);
+                key.append(pSamplers, sizeof(VkSampler) * binding.descriptorCount);
+            }
+        }
+        std::lock_guard lock(mutex);
+        if (auto pLayout = Find(descriptorSetLayouts, key)) { return pLayout; }
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+            .bindingCount = static_cast<uint32_t>(sortedBindingFlags.size()),
+            .pBindingFlags = sortedBindingFlags.data()
+        };
+        VkDescriptorSetLayoutCreateInfo createInfo = {
+            .pNext = std::ranges::any_of(sortedBindingFlags, std::identity{}) ? &bindingFlagsCreateInfo : nullptr,
+            .flags = flags,
+            .bindingCount = static_cast<uint32_t>(sortedBindings.size()),
+            .pBindings = sortedBindings.data()
+        };
+        auto pLayout = std::make_shared<descriptorSetLayout>();
+        if (VkResult result = pLayout->Create(createInfo)) { return {}; }
+        keysBySetLayout.emplace(static_cast<VkDescriptorSetLayout>(*pLayout), key);
+        return descriptorSetLayouts.emplace(std::move(key), std::move(pLayout)).first->second;
+    }
+    // 取得管线布局，push constant范围的顺序不影响结果
+    std::shared_ptr<const pipelineLayout> PipelineLayout(
+        arrayRef<const VkDescriptorSetLayout> setLayouts, arrayRef<const VkPushConstantRange> pushConstantRanges = {}
+    ) {
+        std::vector<VkPushConstantRange> sortedRanges(pushConstantRanges.begin(), pushConstantRanges.end());
+        std::ranges::sort(sortedRanges, {}, [](const VkPushConstantRange& i) {
+            return std::tuple(i.offset, i.size, i.stageFlags);
+        });
+        std::string key;
+        Append(key, setLayouts.Count());
+        std::lock_guard lock(mutex);
+        // 描述符集布局以内容区分，其handle在销毁后被复用也不会误判
+        for (auto& i : setLayouts) {
+            if (auto iterator = keysBySetLayout.find(i); iterator != keysBySetLayout.end()) {
+                Append(key, true, iterator->second.size());
+                key.append(iterator->second);
+            } else {
+                Append(key, false, i);
+            }
+        }
+        for (auto& i : sortedRanges) { Append(key, i.stageFlags, i.offset, i.size); }
+        if (auto pLayout = Find(pipelineLayouts, key)) { return pLayout; }
+        VkPipelineLayoutCreateInfo createInfo = {
+            .setLayoutCount = static_cast<uint32_t>(setLayouts.Count()),
+            .pSetLayouts = setLayouts.Pointer(),
+            .pushConstantRangeCount = static_cast<uint32_t>(sortedRanges.size()),
+            .pPushConstantRanges = sortedRanges.data()
+        };
+        auto pLayout = std::make_shared<pipelineLayout>();
+        if (VkResult result = pLayout->Create(createInfo)) { return {}; }
+        keysByPipelineLayout.emplace(static_cast<VkPipelineLayout>(*pLayout), key);
+        return pipelineLayouts.emplace(std::move(key), std::move(pLayout)).first->second;
+    }
+    // 释放仅被缓存持有的布局
+    void ReleaseUnused() {
+        std::lock_guard lock(mutex);
+        std::erase_if(pipelineLayouts, [this](const auto& i) {
+            if (i.second.use_count() > 1) { return false; }
+            keysByPipelineLayout.erase(static_cast<VkPipelineLayout>(*i.second));
+            return true;
+        });
+        std::erase_if(descriptorSetLayouts, [this](const auto& i) {
+            if (i.second.use_count() > 1) { return false; }
+            keysBySetLayout.erase(static_cast<VkDescriptorSetLayout>(*i.second));
+            return true;
+        });
+    }
+    void Clear() {
+        std::lock_guard lock(mutex);
+        pipelineLayouts.clear();
+        keysByPipelineLayout.clear();
+        keysBySetLayout.clear();
+        descriptorSetLayouts.clear();
+    }
+    // Static function
+    static layoutCache& Get() { return graphicsBase::OwnedSingleton<layoutCache>(); }
+};
+
+/**
+ * 管线登记表，按创建信息的内容对管线去重
+ * 将创建信息中影响管线的所有内容（着色器阶段及特化常量、顶点输入、各固定功能状态、动态状态、管线布局、渲染通道及子通道）
+ * 逐字段序列化为键，内容相同的创建信息得到同一个共享的管线；以字节比较键，哈希冲突不会导致误判
+ * 由shaderModuleCache创建的着色器模块以SPIR-V内容的哈希计入键，由layoutCache创建的管线布局以其内容计入键，handle被复用也不会误判
+ * 渲染通道及其他管线布局以handle计入键，销毁前须调用EraseRenderPass(...)或ErasePipelineLayout(...)，以免取得过期的管线
+ * 创建信息、着色器阶段或任一状态结构体带pNext链时无法完整序列化，不参与去重，每次都创建新管线
+ * 须在销毁逻辑设备前销毁或调用Clear()，外部持有的管线同样须在此之前释放
+ */
+class pipelineRegistry {
+    struct keyHash {
+        size_t operator()(const std::string& key) const { return static_cast<size_t>(Hash(key)); }
+    };
+    struct entry {
+        std::shared_ptr<const pipeline> pPipeline;
+        VkRenderPass renderPass;  // 计算管线为VK_NULL_HANDLE
+        VkPipelineLayout layout;
+    };
+    std::unordered_map<std::string, entry, keyHash> pipelines;
+    mutable std::mutex mutex;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+
+    template <typename... T>
+    static void Append(std::string& key, const T&... values) {
+        (key.append(reinterpret_cast<const char*>(&values), sizeof values), ...);
+    }
+    // 仅用于无填充字节的结构体数组
+    template <typename T>
+    static void AppendArray(std::string& key, const T* pArray, uint32_t count) {
+        if (!pArray) { count = 0; }
+        Append(key, count);
+        key.append(reinterpret_cast<const char*>(pArray), sizeof(T) * count);
+    }
+    // 记录指针是否为空，返回指针是否非空
+    static bool Present(std::string& key, const void* pointer) {
+        Append(key, bool(pointer));
+        return pointer;
+    }
+    // 由shaderModuleCache创建的着色器模块以内容区分，其handle在销毁后被复用也不会误判
+    // 其他模块以handle区分，销毁后被复用的handle须先Clear()
+    static void AppendStage(std::string& key, const VkPipelineShaderStageCreateInfo& stage) {
+        Append(key, stage.flags, stage.stage);
+        if (std::optional<uint64_t> codeHash = shaderModuleCache::Get().CodeHash(stage.module)) {
+            Append(key, true, *codeHash);
+        } else {
+            Append(key, false, stage.module);
+        }
+        key.append(stage.pName ? stage.pName : "").push_back('\0');
+        const VkSpecializationInfo* pInfo = stage.pSpecializationInfo;
+        if (!Present(key, pInfo)) { return; }
+        AppendArray(key, pInfo->pMapEntries, pInfo->mapEntryCount);
+        Append(key, pInfo->dataSize);
+        key.append(static_cast<const char*>(pInfo->pData), pInfo->dataSize);
+    }
+    // 由layoutCache创建的管线布局以内容区分，其他布局以handle区分
+    static void AppendLayout(std::string& key, VkPipelineLayout layout) {
+        if (std::optional<std::string> layoutKey = layoutCache::Get().PipelineLayoutKey(layout)) {
+            Append(key, true, layoutKey->size());
+            key.append(*layoutKey);
+        } else {
+            Append(key, false, layout);
+        }
+    }
+
+    std::shared_ptr<const pipeline> Find(const std::string& key) {
+        std::lock_guard lock(mutex);
+        auto iterator = pipelines.find(key);
+        if (iterator == pipelines.end()) {
+            missCount++;
+            return {};
+        }
+        hitCount++;
+        return iterator->second.pPipeline;
+    }
+    template <typename T>
+    std::shared_ptr<const pipeline> FindOrCreate(
+        T& createInfo, bool deduplicable, const std::string& key, VkRenderPass renderPass
+    ) {
+        if (deduplicable) {
+            if (auto pPipeline = Find(key)) { return pPipeline; }
+        }
+        // 编译期间不持有锁；若其他线程同时创建了相同的管线，则沿用先登记的那个
+        auto pPipeline = std::make_shared<pipeline>();
+        if (VkResult result = pPipeline->Create(createInfo)) { return {}; }
+        if (!deduplicable) { return pPipeline; }
+        std::lock_guard lock(mutex);
+        entry newEntry = {std::move(pPipeline), renderPass, createInfo.layout};
+        return pipelines.try_emplace(key, std::move(newEntry)).first->second.pPipeline;
+    }
+
+  public:
+    pipelineRegistry() = default;
+    pipelineRegistry(pipelineRegistry&&) = delete;
+    // Getter
+    uint64_t HitCount() const {
+        std::lock_guard lock(mutex);
+        return hitCount;
+    }
+    uint64_t MissCount() const {
+        std::lock_guard lock(mutex);
+        return missCount;
+    }
+    size_t Size() const {
+        std::lock_guard lock(mutex);
+        return pipelines.size();
+    }
+    // Non-const function
+    // 取得与创建信息对应的管线，登记表中没有时创建并登记，创建失败时返回空指针
+    std::shared_ptr<const pipeline> Get(VkGraphicsPipelineCreateInfo& createInfo) {
+        return FindOrCreate(createInfo, Deduplicable(createInfo), Key(createInfo), createInfo.renderPass);
+    }
+    std::shared_ptr<const pipeline> Get(VkComputePipelineCreateInfo& createInfo) {
+        return FindOrCreate(createInfo, Deduplicable(createInfo), Key(createInfo), VK_NULL_HANDLE);
+    }
+    // 释放仅被登记表自身持有的管线
+    void ReleaseUnused() {
+        std::lock_guard lock(mutex);
+        std::erase_if(pipelines, [](const auto& i) { return i.second.pPipeline.use_count() == 1; });
+    }
+    // 移除以该渲染通道创建的管线，须在销毁渲染通道前调用，外部持有的管线不受影响
+    void EraseRenderPass(VkRenderPass renderPass) {
+        std::lock_guard lock(mutex);
+        std::erase_if(pipelines, [renderPass](const auto& i) { return i.second.renderPass == renderPass; });
+    }
+    // 移除以该管线布局创建的管线，须在销毁不是由layoutCache创建的管线布局前调用，外部持有的管线不受影响
+    void ErasePipelineLayout(VkPipelineLayout layout) {
+        std::lock_guard lock(mutex);
+        std::erase_if(pipelines, [layout](const auto& i) { return i.second.layout == layout; });
+    }
+    void Clear() {
+        std::lock_guard lock(mutex);
+        pipelines.clear();
+    }
+    // Static function
+    // 创建信息及其各着色器阶段、各状态结构体均不带pNext链时，键才完整描述了管线
+    static bool Deduplicable(const VkGraphicsPipelineCreateInfo& createInfo) {
+        auto chained = [](const auto* p) { return p && p->pNext; };
+        for (uint32_t i = 0; i < createInfo.stageCount; i++) {
+            if (createInfo.pStages[i].pNext) { return false; }
+        }
+        return !(false || createInfo.pNext || chained(createInfo.pVertexInputState) ||
+                 chained(createInfo.pInputAssemblyState) || chained(createInfo.pTessellationState) ||
+                 chained(createInfo.pViewportState) || chained(createInfo.pRasterizationState) ||
+                 chained(createInfo.pMultisampleState) || chained(createInfo.pDepthStencilState) ||
+                 chained(createInfo.pColorBlendState) || chained(createInfo.pDynamicState));
+    }
+    static bool Deduplicable(const VkComputePipelineCreateInfo& createInfo) {
+        return !createInfo.pNext && !createInfo.stage.pNext;
+    }
+    // 将创建信息序列化为登记表的键，不含pNext链
+    static std::string Key(const VkGraphicsPipelineCreateInfo& createInfo) {
+        std::string key;
+        Append(key, VK_PIPELINE_BIND_POINT_GRAPHICS, createInfo.flags);
+        AppendLayout(key, createInfo.layout);
+        Append(key, createInfo.renderPass, createInfo.subpass, createInfo.basePipelineHandle);
+        Append(key, createInfo.basePipelineIndex, createInfo.stageCount);
+        for (uint32_t i = 0; i < createInfo.stageCount; i++) { AppendStage(key, createInfo.pStages[i]); }
+        if (auto p = createInfo.pVertexInputState; Present(key, p)) {
+            Append(key, p->flags);
+            AppendArray(key, p->pVertexBindingDescriptions, p->vertexBindingDescriptionCount);
+            AppendArray(key, p->pVertexAttributeDescriptions, p->vertexAttributeDescriptionCount);
+        }
+        if (auto p = createInfo.pInputAssemblyState; Present(key, p)) {
+            Append(key, p->flags, p->topology, p->primitiveRestartEnable);
+        }
+        if (auto p = createInfo.pTessellationState; Present(key, p)) {
+            Append(key, p->flags, p->patchControlPoints);
+        }
+        if (auto p = createInfo.pViewportState; Present(key, p)) {
+            Append(key, p->flags, p->viewportCount, p->scissorCount);
+            AppendArray(key, p->pViewports, p->pViewports ? p->viewportCount : 0);
+            AppendArray(key, p->pScissors, p->pScissors ? p->scissorCount : 0);
+        }
+        if (auto p = createInfo.pRasterizationState; Present(key, p)) {
+            Append(key, p->flags, p->depthClampEnable, p->rasterizerDiscardEnable, p->polygonMode, p->cullMode);
+            Append(key, p->frontFace, p->depthBiasEnable, p->depthBiasConstantFactor, p->depthBiasClamp);
+            Append(key, p->depthBiasSlopeFactor, p->lineWidth);
+        }
+        if (auto p = createInfo.pMultisampleState; Present(key, p)) {
+            Append(key, p->flags, p->rasterizationSamples, p->sampleShadingEnable, p->minSampleShading);
+            Append(key, p->alphaToCoverageEnable, p->alphaToOneEnable);
+            // 采样掩码的长度为ceil(rasterizationSamples / 32)
+            AppendArray(key, p->pSampleMask, (uint32_t(p->rasterizationSamples) + 31) / 32);
+        }
+        if (auto p = createInfo.pDepthStencilState; Present(key, p)) {
+            Append(key, p->flags, p->depthTestEnable, p->depthWriteEnable, p->depthCompareOp);
+            Append(key, p->depthBoundsTestEnable, p->stencilTestEnable, p->front, p->back);
+            Append(key, p->minDepthBounds, p->maxDepthBounds);
+        }
+        if (auto p = createInfo.pColorBlendState; Present(key, p)) {
+            Append(key, p->flags, p->logicOpEnable, p->logicOp, p->blendConstants);
+            AppendArray(key, p->pAttachments, p->attachmentCount);
+        }
+        if (auto p = createInfo.pDynamicState; Present(key, p)) {
+            Append(key, p->flags);
+            AppendArray(key, p->pDynamicStates, p->dynamicStateCount);
+        }
+        return key;
+    }
+    static std::string Key(const VkComputePipelineCreateInfo& createInfo) {
+        std::string key;
+        Append(key, VK_PIPELINE_BIND_POINT_COMPUTE, createInfo.flags);
+        AppendLayout(key, createInfo.layout);
+        Append(key, createInfo.basePipelineHandle, createInfo.basePipelineIndex);
+        AppendStage(key, createInfo.stage);
+        return key;
+    }
+};
+
+/**
+ * 帧上下文
+ * 为每个飞行中的帧持有一个瞬态命令池，命令缓冲区从中按顺序取用、不足时分配，从不单独释放或重置
+ * 某帧的栅栏被触发后调用BeginFrame(...)，以一次vkResetCommandPool(...)回收该帧的所有命令缓冲区，须在销毁逻辑设备前销毁
+ */
+class frameContext {
+    struct perFrame {
+        commandPool commandPool;
+        // 按级别（一级、二级）分别存放，deque保证已取得的命令缓冲区的地址不因扩充而改变
+        std::deque<commandBuffer> commandBuffers[2];
+        size_t usedCounts[2] = {};
+    };
+    std::array<perFrame, MAX_FRAMES_IN_FLIGHT> frames;
+    uint32_t currentFrame = 0;
+
+  public:
+    frameContext() = default;
+    explicit frameContext(uint32_t queueFamilyIndex) { Create(queueFamilyIndex); }
+    frameContext(frameContext&&) = default;
+    // Getter
+    uint32_t CurrentFrame() const { return currentFrame; }
+    // Non-const function
+    // 开始新的一帧并重置该帧的命令池，调用前需确保该帧上一次提交的命令已执行完毕（即帧栅栏已被触发）
+    result_t BeginFrame(uint32_t frameIndex) {
+        currentFrame = frameIndex % MAX_FRAMES_IN_FLIGHT;
+        perFrame& frame = frames[currentFrame];
+        frame.usedCounts[0] = frame.usedCounts[1] = 0;
+        return frame.commandPool.Reset();
+    }
+    // 取得当前帧的下一个命令缓冲区，在下一次对该帧调用BeginFrame(...)前有效，分配失败时返回nullptr
+    const commandBuffer* AcquireCommandBuffer(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
+        perFrame& frame = frames[currentFrame];
+        auto& commandBuffers = frame.commandBuffers[level == VK_COMMAND_BUFFER_LEVEL_SECONDARY];
+        size_t& usedCount = frame.usedCounts[level == VK_COMMAND_BUFFER_LEVEL_SECONDARY];
+        if (usedCount == commandBuffers.size()) {
+            if (VkResult result = frame.commandPool.AllocateBuffers(arrayRef(commandBuffers.emplace_back()), level)) {
+                commandBuffers.pop_back();
+                return nullptr;
+            }
+        }
+        return &commandBuffers[usedCount++];
+    }
+    void Create(uint32_t queueFamilyIndex) {
+        for (auto& frame : frames) {
+            frame.commandPool.Create(queueFamilyIndex, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        }
+    }
+};
+
+/**
+ * 以二级命令缓冲区多线程录制渲染通道中的命令
+ * 每个工作线程各有一个frameContext，二级命令缓冲区从中取用，BeginFrame(...)时整池重置
+ * Record(...)将任务按序号均分给各线程，各自录制到一个二级命令缓冲区，全部完成后按线程序号在主命令缓冲区中执行
+ * 主命令缓冲区须以VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS开始渲染通道，须在销毁逻辑设备前销毁
+ */
+class parallelRecorder {
+  public:
+    // 在commandBuffer中录制序号在[begin, end)范围内的任务，视口和裁剪范围已被设置为渲染区域
+    using recordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end)>;
+
+  private:
+    struct worker {
+        frameContext frameContext;
+        std::thread thread;
+    };
+    std::vector<worker> workers;
+    // 以下成员由mutex保护，工作线程只在Record(...)等待期间读取当前任务
+    std::mutex mutex;
+    std::condition_variable condition_work;
+    std::condition_variable condition_done;
+    uint64_t generation = 0;  // 每次Record(...)递增，工作线程据此得知有新任务
+    uint32_t pendingCount = 0;
+    bool stop = false;
+    const recordFunction* pRecord = nullptr;
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    VkRect2D renderArea = {};
+    uint32_t taskCount = 0;
+    std::vector<VkCommandBuffer> recordedBuffers;  // 按线程序号排列，未录制的为VK_NULL_HANDLE
+
+    // 在第index个工作线程中录制分给它的任务，失败时该线程的录制结果被丢弃
+    VkCommandBuffer RecordRange(uint32_t index) {
+        uint32_t begin = static_cast<uint32_t>(uint64_t(taskCount) * index / workers.size());
+        uint32_t end = static_cast<uint32_t>(uint64_t(taskCount) * (index + 1) / workers.size());
+        if (begin == end) { return VK_NULL_HANDLE; }
+        auto pCommandBuffer = workers[index].frameContext.AcquireCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+        if (!pCommandBuffer) { return VK_NULL_HANDLE; }
+        const commandBuffer& commandBuffer = *pCommandBuffer;
+        VkCommandBufferInheritanceInfo inheritanceInfo = this->inheritanceInfo;
+        VkCommandBufferUsageFlags usageFlags =
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        if (VkResult result = commandBuffer.Begin(usageFlags, inheritanceInfo)) { return VK_NULL_HANDLE; }
+        // 动态状态不会从主命令缓冲区继承
+        renderPass::CmdSetViewportAndScissor(commandBuffer, renderArea);
+        (*pRecord)(commandBuffer, begin, end);
+        if (VkResult result = commandBuffer.End()) { return VK_NULL_HANDLE; }
+        return commandBuffer;
+    }
+    void Work(uint32_t index) {
+        uint64_t finishedGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock lock(mutex);
+                condition_work.wait(lock, [&] { return stop || generation != finishedGeneration; });
+                if (stop) { return; }
+                finishedGeneration = generation;
+            }
+            VkCommandBuffer recordedBuffer = RecordRange(index);
+            std::lock_guard lock(mutex);
+            recordedBuffers[index] = recordedBuffer;
+            if (!--pendingCount) { condition_done.notify_one(); }
+        }
+    }
+
+  public:
+    explicit parallelRecorder(
+        uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u),
+        uint32_t queueFamilyIndex = graphicsBase::Base().QueueFamilyIndex_Graphics()
+    )
+        : workers(std::max(threadCount, 1u)), recordedBuffers(workers.size()) {
+        for (auto& worker : workers) { worker.frameContext.Create(queueFamilyIndex); }
+        for (uint32_t i = 0; i < workers.size(); i++) {
+            workers[i].thread = std::thread(&parallelRecorder::Work, this, i);
+        }
+    }
+    parallelRecorder(parallelRecorder&&) = delete;
+    ~parallelRecorder() {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        condition_work.notify_all();
+        for (auto& worker : workers) { worker.thread.join(); }
+    }
+    // Getter
+    uint32_t ThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+    // Non-const function
+    // 开始新的一帧并重置各线程中该帧的命令池，调用前需确保该帧上一次提交的命令已执行完毕（即帧栅栏已被触发）
+    result_t BeginFrame(uint32_t frameIndex) {
+        for (auto& worker : workers) {
+            if (VkResult result = worker.frameContext.BeginFrame(frameIndex)) { return result; }
+        }
+        return VK_SUCCESS;
+    }
+    /**
+     * 在工作线程中并行录制taskCount个任务，阻塞直至全部录制完成，再在primaryCommandBuffer中执行所得的二级命令缓冲区
+     * inheritanceInfo需指定renderPass、subpass、framebuffer，record会在各工作线程中被同时调用
+     */
+    void Record(
+        VkCommandBuffer primaryCommandBuffer, VkCommandBufferInheritanceInfo inheritanceInfo, VkRect2D renderArea,
+        uint32_t taskCount, const recordFunction& record
+    ) {
+        std::unique_lock lock(mutex);
+        this->inheritanceInfo = inheritanceInfo;
+        this->inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        this->renderArea = renderArea;
+        this->taskCount = taskCount;
+        pRecord = &record;
+        pendingCount = static_cast<uint32_t>(workers.size());
+        generation++;
+        condition_work.notify_all();
+        condition_done.wait(lock, [&] { return !pendingCount; });
+        pRecord = nullptr;
+        std::vector<VkCommandBuffer> commandBuffers;
+        for (VkCommandBuffer i : recordedBuffers) {
+            if (i) { commandBuffers.push_back(i); }
+        }
+        if (commandBuffers.empty()) { return; }
+        vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+    }
+};
+
+/**
+ * 管线屏障批次
+ * 收集缓冲区和图像的内存屏障，Flush(...)时以一次vkCmdPipelineBarrier(...)录制并清空，之后可再次使用
+ * 同一图像的屏障若除子资源范围外完全相同，且范围在图层或mip级别上相邻，会被合并为一个
+ */
+class pipelineBarrierBatch {
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+    std::vector<VkBufferMemoryBarrier> bufferMemoryBarriers;
+    std::vector<VkImageMemoryBarrier> imageMemoryBarriers;
+
+    // 尝试将barrier合并到last中
+    static bool Merge(VkImageMemoryBarrier& last, const VkImageMemoryBarrier& barrier) {
+        VkImageSubresourceRange& a = last.subresourceRange;
+        const VkImageSubresourceRange& b = barrier.subresourceRange;
+        if (last.image != barrier.image || last.pNext || barrier.pNext ||
+            last.srcAccessMask != barrier.srcAccessMask || last.dstAccessMask != barrier.dstAccessMask ||
+            last.oldLayout != barrier.oldLayout || last.newLayout != barrier.newLayout ||
+            last.srcQueueFamilyIndex != barrier.srcQueueFamilyIndex ||
+            last.dstQueueFamilyIndex != barrier.dstQueueFamilyIndex || a.aspectMask != b.aspectMask ||
+            a.levelCount == VK_REMAINING_MIP_LEVELS || b.levelCount == VK_REMAINING_MIP_LEVELS ||
+            a.layerCount == VK_REMAINING_ARRAY_LAYERS || b.layerCount == VK_REMAINING_ARRAY_LAYERS) {
+            return false;
+        }
+        if (a.baseMipLevel == b.baseMipLevel && a.levelCount == b.levelCount &&
+            a.baseArrayLayer + a.layerCount == b.baseArrayLayer) {
+            a.layerCount += b.layerCount;
+            return true;
+        }
+        if (a.baseArrayLayer == b.baseArrayLayer && a.layerCount == b.layerCount &&
+            a.baseMipLevel + a.levelCount == b.baseMipLevel) {
+            a.levelCount += b.levelCount;
+            return true;
+        }
+        return false;
+    }
+
+  public:
+    // Getter
+    VkPipelineStageFlags SrcStages() const { return srcStages; }
+    VkPipelineStageFlags DstStages() const { return dstStages; }
+    const std::vector<VkBufferMemoryBarrier>& BufferMemoryBarriers() const { return bufferMemoryBarriers; }
+    const std::vector<VkImageMemoryBarrier>& ImageMemoryBarriers() const { return imageMemoryBarriers; }
+    // Const function
+    bool Empty() const { return bufferMemoryBarriers.empty() && imageMemoryBarriers.empty(); }
+    // Non-const function
+    void Add(VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages, const VkBufferMemoryBarrier& barrier) {
+        this->srcStages |= srcStages;
+        this->dstStages |= dstStages;
+        bufferMemoryBarriers.push_back(barrier);
+    }
+    void Add(VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages, const VkImageMemoryBarrier& barrier) {
+        this->srcStages |= srcStages;
+        this->dstStages |= dstStages;
+        if (imageMemoryBarriers.size() && Merge(imageMemoryBarriers.back(), barrier)) { return; }
+        imageMemoryBarriers.push_back(barrier);
+    }
+    // 录制收集到的所有屏障，没有屏障时不录制任何命令，不需要等待任何阶段时以VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT代替
+    void Flush(VkCommandBuffer commandBuffer) {
+        if (Empty()) { return; }
+        vkCmdPipelineBarrier(
+            commandBuffer, srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            dstStages ? dstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+            static_cast<uint32_t>(bufferMemoryBarriers.size()), bufferMemoryBarriers.data(),
+            static_cast<uint32_t>(imageMemoryBarriers.size()), imageMemoryBarriers.data()
+        );
+        Clear();
+    }
+    void Clear() {
+        srcStages = dstStages = 0;
+        bufferMemoryBarriers.clear();
+        imageMemoryBarriers.clear();
+    }
+};
+
+/**
+ * 资源状态跟踪器
+ * 按子资源（mip级别和图层）记录图像的布局、最近一次写入的阶段和访问类型、此后已与之同步的读取、所属队列族，缓冲区则整体记录
+ * 每次使用资源前以UseImage(...)或UseBuffer(...)声明本次使用，所需的最少屏障被加入批次，在使用资源的命令前调用Flush(...)一次性录制
+ * 访问类型中含写入时视作写入，写入和布局转换须等待之前所有的读写，读取只需等待尚未与之同步的最近一次写入，读后读不产生屏障
+ * 图像的各个aspect被视作一体，不分别跟踪
+ */
+class resourceStateTracker {
+  public:
+    struct accessState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags writeStages = 0;
+        VkAccessFlags writeAccesses = 0;
+        VkPipelineStageFlags readStages = 0;
+        VkAccessFlags readAccesses = 0;
+        uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;  // 为VK_QUEUE_FAMILY_IGNORED时不做所有权转移
+    };
+    static constexpr VkAccessFlags writeAccesses = VK_ACCESS_SHADER_WRITE_BIT |
+                                                   VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                                   VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                                   VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT |
+                                                   VK_ACCESS_MEMORY_WRITE_BIT;
+
+  private:
+    struct imageStates {
+        VkImageAspectFlags aspectMask;
+        uint32_t mipLevelCount;
+        uint32_t arrayLayerCount;
+        std::vector<accessState> states;  // 索引为mip级别 * arrayLayerCount + 图层
+    };
+    // 一个子资源所需的屏障，除needed外的成员仅在needed为true时有意义
+    struct transition {
+        bool needed = false;
+        VkPipelineStageFlags srcStages = 0;
+        VkAccessFlags srcAccesses = 0;
+        VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bool operator==(const transition&) const = default;
+    };
+    std::unordered_map<VkImage, imageStates> images;
+    std::unordered_map<VkBuffer, accessState> buffers;
+    pipelineBarrierBatch batch;
+
+    // 计算从state到本次使用所需的屏障并更新state，对缓冲区而言layout应为state.layout
+    static transition Transition(
+        accessState& state, VkPipelineStageFlags stages, VkAccessFlags accesses, VkImageLayout layout,
+        uint32_t queueFamilyIndex
+    ) {
+        transition transition = {.oldLayout = state.layout};
+        bool writes = accesses & writeAccesses;
+        bool transfersOwnership = queueFamilyIndex != VK_QUEUE_FAMILY_IGNORED &&
+                                  state.queueFamilyIndex != VK_QUEUE_FAMILY_IGNORED &&
+                                  queueFamilyIndex != state.queueFamilyIndex;
+        if (transfersOwnership) {
+            transition.srcQueueFamilyIndex = state.queueFamilyIndex;
+            transition.dstQueueFamilyIndex = queueFamilyIndex;
+        }
+        if (queueFamilyIndex != VK_QUEUE_FAMILY_IGNORED) { state.queueFamilyIndex = queueFamilyIndex; }
+        if (writes || layout != state.layout || transfersOwnership) {
+            // 写入、布局转换、所有权转移须等待之前所有的读写完成
+            transition.srcStages = state.writeStages | state.readStages;
+            transition.srcAccesses = state.writeAccesses;
+            transition.needed = transition.srcStages || layout != state.layout || transfersOwnership;
+            state.layout = layout;
+            state.writeStages = stages;
+            state.writeAccesses = accesses & writeAccesses;
+            // 屏障的结果对本次使用可见
+            state.readStages = writes ? 0 : stages;
+            state.readAccesses = writes ? 0 : accesses;
+        } else {
+            if (state.writeStages && (stages & ~state.readStages || accesses & ~state.readAccesses)) {
+                transition.srcStages = state.writeStages;
+                transition.srcAccesses = state.writeAccesses;
+                transition.needed = true;
+            }
+            state.readStages |= stages;
+            state.readAccesses |= accesses;
+        }
+        return transition;
+    }
+    imageStates* FindImage(VkImage image) {
+        auto iterator = images.find(image);
+        if (iterator == images.end()) {
+            outStream << std::format("[ resourceStateTracker ] ERROR\nThe image is not tracked!\n");
+            return nullptr;
+        }
+        return &iterator->second;
+    }
+
+  public:
+    // Getter
+    const pipelineBarrierBatch& Batch() const { return batch; }
+    // Const function
+    // 取得图像某一子资源的状态，未跟踪该图像时返回nullptr
+    const accessState* ImageState(VkImage image, uint32_t mipLevel = 0, uint32_t arrayLayer = 0) const {
+        auto iterator = images.find(image);
+        if (iterator == images.end()) { return nullptr; }
+        return &iterator->second.states[mipLevel * iterator->second.arrayLayerCount + arrayLayer];
+    }
+    const accessState* BufferState(VkBuffer buffer) const {
+        auto iterator = buffers.find(buffer);
+        return iterator == buffers.end() ? nullptr : &iterator->second;
+    }
+    // Non-const function
+    // 开始跟踪图像，已在跟踪时重置其状态，initialLayout不为VK_IMAGE_LAYOUT_UNDEFINED时，视作已同步到所有阶段
+    void TrackImage(
+        VkImage image, VkImageAspectFlags aspectMask, uint32_t mipLevelCount = 1, uint32_t arrayLayerCount = 1,
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED
+    ) {
+        accessState state = {.layout = initialLayout, .queueFamilyIndex = queueFamilyIndex};
+        images[image] = {
+            aspectMask, mipLevelCount, arrayLayerCount, std::vector(mipLevelCount * arrayLayerCount, state)
+        };
+    }
+    // 缓冲区在首次使用时自动开始跟踪，仅在需指定所属队列族时调用
+    void TrackBuffer(VkBuffer buffer, uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED) {
+        buffers[buffer] = {.queueFamilyIndex = queueFamilyIndex};
+    }
+    // 停止跟踪，应在销毁资源时调用，以免句柄被复用后沿用旧状态
+    void Untrack(VkImage image) { images.erase(image); }
+    void Untrack(VkBuffer buffer) { buffers.erase(buffer); }
+    /**
+     * 声明对图像的子资源范围的一次使用，所需屏障被加入批次
+     * queueFamilyIndex与记录的队列族不同时生成所有权转移的获取屏障，对应的释放屏障须另行在原队列族上录制
+     */
+    void UseImage(
+        VkImage image, const VkImageSubresourceRange& subresourceRange, VkPipelineStageFlags stages,
+        VkAccessFlags accesses, VkImageLayout layout, uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED
+    ) {
+        imageStates* pImage = FindImage(image);
+        if (!pImage) { return; }
+        uint32_t levelCount = subresourceRange.levelCount == VK_REMAINING_MIP_LEVELS ?
+                                  pImage->mipLevelCount - subresourceRange.baseMipLevel :
+                                  subresourceRange.levelCount;
+        uint32_t layerCount = subresourceRange.layerCount == VK_REMAINING_ARRAY_LAYERS ?
+                                  pImage->arrayLayerCount - subresourceRange.baseArrayLayer :
+                                  subresourceRange.layerCount;
+        for (uint32_t mipLevel = subresourceRange.baseMipLevel; mipLevel < subresourceRange.baseMipLevel + levelCount;
+             mipLevel++) {
+            // 同一mip级别中所需屏障相同的相邻图层合为一个屏障
+            transition run;
+            uint32_t runBase = 0, runCount = 0;
+            auto AddRun = [&] {
+                if (!runCount || !run.needed) { return; }
+                batch.Add(run.srcStages, stages, VkImageMemoryBarrier{
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = run.srcAccesses,
+                    .dstAccessMask = accesses,
+                    .oldLayout = run.oldLayout,
+                    .newLayout = layout,
+                    .srcQueueFamilyIndex = run.srcQueueFamilyIndex,
+                    .dstQueueFamilyIndex = run.dstQueueFamilyIndex,
+                    .image = image,
+                    .subresourceRange = {subresourceRange.aspectMask, mipLevel, 1, runBase, runCount}
+                });
+            };
+            for (uint32_t layer = subresourceRange.baseArrayLayer; layer < subresourceRange.baseArrayLayer + layerCount;
+                 layer++) {
+                transition transition = Transition(
+                    pImage->states[mipLevel * pImage->arrayLayerCount + layer], stages, accesses, layout,
+                    queueFamilyIndex
+                );
+                if (runCount && transition == run) {
+                    runCount++;
+                    continue;
+                }
+                AddRun();
+                run = transition;
+                runBase = layer;
+                runCount = 1;
+            }
+            AddRun();
+        }
+    }
+    // 声明对整个图像的一次使用
+    void UseImage(
+        VkImage image, VkPipelineStageFlags stages, VkAccessFlags accesses, VkImageLayout layout,
+        uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED
+    ) {
+        imageStates* pImage = FindImage(image);
+        if (!pImage) { return; }
+        UseImage(
+            image, {pImage->aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS}, stages, accesses,
+            layout, queueFamilyIndex
+        );
+    }
+    // 声明对整个缓冲区的一次使用
+    void UseBuffer(
+        VkBuffer buffer, VkPipelineStageFlags stages, VkAccessFlags accesses,
+        uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED
+    ) {
+        accessState& state = buffers[buffer];
+        transition transition = Transition(state, stages, accesses, state.layout, queueFamilyIndex);
+        if (!transition.needed) { return; }
+        batch.Add(transition.srcStages, stages, VkBufferMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = transition.srcAccesses,
+            .dstAccessMask = accesses,
+            .srcQueueFamilyIndex = transition.srcQueueFamilyIndex,
+            .dstQueueFamilyIndex = transition.dstQueueFamilyIndex,
+            .buffer = buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        });
+    }
+    /**
+     * 直接设定图像的子资源范围的状态，不产生屏障
+     * 用于记录在跟踪器之外发生的转换，如渲染通道结束时附件转到finalLayout（此时stages和accesses为附件的写入）
+     */
+    void SetImageState(VkImage image, const VkImageSubresourceRange& subresourceRange, const accessState& state) {
+        imageStates* pImage = FindImage(image);
+        if (!pImage) { return; }
+        uint32_t levelCount = subresourceRange.levelCount == VK_REMAINING_MIP_LEVELS ?
+                                  pImage->mipLevelCount - subresourceRange.baseMipLevel :
+                                  subresourceRange.levelCount;
+        uint32_t layerCount = subresourceRange.layerCount == VK_REMAINING_ARRAY_LAYERS ?
+                                  pImage->arrayLayerCount - subresourceRange.baseArrayLayer :
+                                  subresourceRange.layerCount;
+        for (uint32_t mipLevel = 0; mipLevel < levelCount; mipLevel++) {
+            for (uint32_t layer = 0; layer < layerCount; layer++) {
+                pImage->states[(subresourceRange.baseMipLevel + mipLevel) * pImage->arrayLayerCount +
+                               subresourceRange.baseArrayLayer + layer] = state;
+            }
+        }
+    }
+    // 以一次vkCmdPipelineBarrier(...)录制自上次Flush(...)以来所需的屏障
+    void Flush(VkCommandBuffer commandBuffer) { batch.Flush(commandBuffer); }
+    // 丢弃未录制的屏障并停止跟踪所有资源
+    void Clear() {
+        batch.Clear();
+        images.clear();
+        buffers.clear();
+    }
+};
+
+/**
+ * 缓存状态的命令编码器
+ * 包装一个命令缓冲区，记录已绑定的管线、各组描述符集及其动态偏移、顶点和索引缓冲区、推送常量、动态状态，
+ * 与已记录的状态相同的绑定和设置命令不会被录制，SkippedCount()返回被跳过的命令数
+ * 以其他方式改变了命令缓冲区的状态后（如renderPass::CmdBegin(...)设置视口和裁剪范围、执行二级命令缓冲区），须调用Reset()
+ * 更换图形管线时，新管线中的静态状态会覆盖对应的动态状态，因此已记录的动态状态均被视作失效
+ * 绑定描述符集或推送常量时所用的管线布局与上一次不同时，保守地视作之前（各绑定点）绑定的描述符集和推送常量均已失效
+ */
+class commandEncoder {
+    struct descriptorSetBinding {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        // 同一次vkCmdBindDescriptorSets(...)绑定的各组描述符集共享动态偏移，因此记录该次绑定的范围
+        uint32_t groupFirst = 0;
+        uint32_t groupCount = 0;
+        std::vector<uint32_t> dynamicOffsets;
+    };
+    struct bindPointState {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        std::vector<descriptorSetBinding> descriptorSets;
+    };
+    struct vertexBufferBinding {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        bool operator==(const vertexBufferBinding&) const = default;
+    };
+    VkCommandBuffer handle = VK_NULL_HANDLE;
+    bindPointState bindPoints[2];  // 依次对应VK_PIPELINE_BIND_POINT_GRAPHICS和VK_PIPELINE_BIND_POINT_COMPUTE
+    std::vector<vertexBufferBinding> vertexBuffers;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize indexOffset = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;  // 最近一次绑定描述符集或推送常量时所用的管线布局
+    std::vector<uint8_t> pushConstantData;
+    std::vector<VkShaderStageFlags> pushConstantStages;  // 各字节最近一次被推送时的阶段，为0表示未推送
+    std::vector<std::pair<bool, VkViewport>> viewports;  // first为是否已设置
+    std::vector<std::pair<bool, VkRect2D>> scissors;
+    std::pair<bool, float> lineWidth;
+    std::pair<bool, std::array<float, 3>> depthBias;
+    std::pair<bool, std::array<float, 4>> blendConstants;
+    std::pair<bool, uint32_t> stencilReferences[2];  // 依次对应正面和背面
+    uint32_t recordedCount = 0;
+    uint32_t skippedCount = 0;
+
+    bindPointState& BindPoint(VkPipelineBindPoint bindPoint) {
+        return bindPoints[bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE];
+    }
+    // 管线布局改变时，已绑定的描述符集和推送常量一并失效
+    void UsePipelineLayout(VkPipelineLayout pipelineLayout) {
+        if (this->pipelineLayout == pipelineLayout) { return; }
+        this->pipelineLayout = pipelineLayout;
+        for (auto& i : bindPoints) { i.descriptorSets.clear(); }
+        pushConstantData.clear();
+        pushConstantStages.clear();
+    }
+    void ForgetDynamicStates() {
+        viewports.clear();
+        scissors.clear();
+        lineWidth.first = depthBias.first = blendConstants.first = false;
+        stencilReferences[0].first = stencilReferences[1].first = false;
+    }
+    // 比较并更新某一动态状态，与已记录的值相同时返回false并计数
+    template <typename T>
+    bool Update(std::pair<bool, T>& state, const T& value) {
+        if (state.first && !memcmp(&state.second, &value, sizeof value)) {
+            skippedCount++;
+            return false;
+        }
+        state = {true, value};
+        recordedCount++;
+        return true;
+    }
+    // 比较并更新从first开始的一段数组状态，返回需录制的子范围[begin, end)，全部相同时begin == end
+    template <typename T>
+    std::pair<uint32_t, uint32_t> Update(
+        std::vector<std::pair<bool, T>>& states, uint32_t first, arrayRef<const T> values
+    ) {
+        if (states.size() < first + values.Count()) { states.resize(first + values.Count()); }
+        uint32_t begin = UINT32_MAX, end = 0;
+        for (uint32_t i = 0; i < values.Count(); i++) {
+            auto& state = states[first + i];
+            if (state.first && !memcmp(&state.second, &values[i], sizeof(T))) { continue; }
+            state = {true, values[i]};
+            begin = std::min(begin, first + i);
+            end = first + i + 1;
+        }
+        if (begin == UINT32_MAX) {
+            skippedCount++;
+            return {};
+        }
+        recordedCount++;
+        return {begin, end};
+    }
+
+  public:
+    commandEncoder() = default;
+    explicit commandEncoder(VkCommandBuffer commandBuffer) : handle(commandBuffer) {}
+    // Getter
+    operator VkCommandBuffer() const { return handle; }
+    uint32_t RecordedCount() const { return recordedCount; }
+    uint32_t SkippedCount() const { return skippedCount; }
+    // Const function
+    void Draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0)
+        const {
+        vkCmdDraw(handle, vertexCount, instanceCount, firstVertex, firstInstance);
+    }
+    void DrawIndexed(
+        uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, int32_t vertexOffset = 0,
+        uint32_t firstInstance = 0
+    ) const {
+        vkCmdDrawIndexed(handle, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    }
+    void Dispatch(uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1) const {
+        vkCmdDispatch(handle, groupCountX, groupCountY, groupCountZ);
+    }
+    // Non-const function
+    void BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline) {
+        VkPipeline& current = BindPoint(bindPoint).pipeline;
+        if (current == pipeline) {
+            skippedCount++;
+            return;
+        }
+        current = pipeline;
+        if (bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) { ForgetDynamicStates(); }
+        recordedCount++;
+        vkCmdBindPipeline(handle, bindPoint, pipeline);
+    }
+    // 没有动态偏移时，只录制与已绑定的描述符集不同的那一段
+    void BindDescriptorSets(
+        VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t firstSet,
+        arrayRef<const VkDescriptorSet> descriptorSets, arrayRef<const uint32_t> dynamicOffsets = {}
+    ) {
+        UsePipelineLayout(pipelineLayout);
+        bindPointState& state = BindPoint(bindPoint);
+        uint32_t setCount = static_cast<uint32_t>(descriptorSets.Count());
+        if (state.descriptorSets.size() < firstSet + setCount) { state.descriptorSets.resize(firstSet + setCount); }
+        std::span<const uint32_t> offsets(dynamicOffsets.Pointer(), dynamicOffsets.Count());
+        uint32_t begin = UINT32_MAX, end = 0;
+        for (uint32_t i = 0; i < setCount; i++) {
+            descriptorSetBinding& binding = state.descriptorSets[firstSet + i];
+            bool same = binding.set == descriptorSets[i] && std::ranges::equal(binding.dynamicOffsets, offsets) &&
+                        (offsets.empty() || binding.groupFirst == firstSet && binding.groupCount == setCount);
+            if (same) { continue; }
+            begin = std::min(begin, i);
+            end = i + 1;
+        }
+        if (begin == UINT32_MAX) {
+            skippedCount++;
+            return;
+        }
+        // 有动态偏移时无法得知各组描述符集对应的偏移，须整段录制
+        if (offsets.size()) {
+            begin = 0;
+            end = setCount;
+        }
+        for (uint32_t i = begin; i < end; i++) {
+            state.descriptorSets[firstSet + i] = {
+                descriptorSets[i], firstSet, setCount, std::vector(offsets.begin(), offsets.end())
+            };
+        }
+        recordedCount++;
+        vkCmdBindDescriptorSets(
+            handle, bindPoint, pipelineLayout, firstSet + begin, end - begin, descriptorSets.Pointer() + begin,
+            static_cast<uint32_t>(offsets.size()), offsets.data()
+        );
+    }
+    void BindDescriptorSet(
+        VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set, VkDescriptorSet descriptorSet,
+        arrayRef<const uint32_t> dynamicOffsets = {}
+    ) {
+        BindDescriptorSets(
+            bindPoint, pipelineLayout, set, arrayRef<const VkDescriptorSet>(descriptorSet), dynamicOffsets
+        );
+    }
+    // 只录制与已绑定的顶点缓冲区不同的那一段，offsets为空时偏移均为0
+    void BindVertexBuffers(
+        uint32_t firstBinding, arrayRef<const VkBuffer> buffers, arrayRef<const VkDeviceSize> offsets = {}
+    ) {
+        uint32_t bindingCount = static_cast<uint32_t>(buffers.Count());
+        if (vertexBuffers.size() < firstBinding + bindingCount) { vertexBuffers.resize(firstBinding + bindingCount); }
+        uint32_t begin = UINT32_MAX, end = 0;
+        for (uint32_t i = 0; i < bindingCount; i++) {
+            vertexBufferBinding binding = {buffers[i], offsets.Count() ? offsets[i] : 0};
+            if (vertexBuffers[firstBinding + i] == binding) { continue; }
+            vertexBuffers[firstBinding + i] = binding;
+            begin = std::min(begin, i);
+            end = i + 1;
+        }
+        if (begin == UINT32_MAX) {
+            skippedCount++;
+            return;
+        }
+        std::vector<VkDeviceSize> offsets_record(end - begin);
+        for (uint32_t i = begin; i < end; i++) { offsets_record[i - begin] = vertexBuffers[firstBinding + i].offset; }
+        recordedCount++;
+        vkCmdBindVertexBuffers(
+            handle, firstBinding + begin, end - begin, buffers.Pointer() + begin, offsets_record.data()
+        );
+    }
+    void BindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset = 0) {
+        BindVertexBuffers(binding, arrayRef<const VkBuffer>(buffer), arrayRef<const VkDeviceSize>(offset));
+    }
+    void BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType) {
+        if (indexBuffer == buffer && indexOffset == offset && this->indexType == indexType) {
+            skippedCount++;
+            return;
+        }
+        indexBuffer = buffer;
+        indexOffset = offset;
+        this->indexType = indexType;
+        recordedCount++;
+        vkCmdBindIndexBuffer(handle, buffer, offset, indexType);
+    }
+    // 推送的各字节在同一管线布局下已以相同阶段推送过相同的值时跳过
+    void PushConstants(
+        VkPipelineLayout pipelineLayout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size,
+        const void* pValues
+    ) {
+        UsePipelineLayout(pipelineLayout);
+        if (pushConstantData.size() < offset + size) {
+            pushConstantData.resize(offset + size);
+            pushConstantStages.resize(offset + size);
+        }
+        if (std::all_of(pushConstantStages.begin() + offset, pushConstantStages.begin() + offset + size,
+                        [&](VkShaderStageFlags stages) { return stages == stageFlags; }) &&
+            !memcmp(pushConstantData.data() + offset, pValues, size)) {
+            skippedCount++;
+            return;
+        }
+        memcpy(pushConstantData.data() + offset, pValues, size);
+        std::fill(pushConstantStages.begin() + offset, pushConstantStages.begin() + offset + size, stageFlags);
+        recordedCount++;
+        vkCmdPushConstants(handle, pipelineLayout, stageFlags, offset, size, pValues);
+    }
+    void SetViewports(uint32_t firstViewport, arrayRef<const VkViewport> viewports) {
+        auto [begin, end] = Update(this->viewports, firstViewport, viewports);
+        if (begin == end) { return; }
+        vkCmdSetViewport(handle, begin, end - begin, viewports.Pointer() + (begin - firstViewport));
+    }
+    void SetViewport(const VkViewport& viewport) { SetViewports(0, arrayRef<const VkViewport>(viewport)); }
+    void SetScissors(uint32_t firstScissor, arrayRef<const VkRect2D> scissors) {
+        auto [begin, end] = Update(this->scissors, firstScissor, scissors);
+        if (begin == end) { return; }
+        vkCmdSetScissor(handle, begin, end - begin, scissors.Pointer() + (begin - firstScissor));
+    }
+    void SetScissor(const VkRect2D& scissor) { SetScissors(0, arrayRef<const VkRect2D>(scissor)); }
+    // 与renderPass::CmdSetViewportAndScissor(...)相同，视口与area一致
+    void SetViewportAndScissor(VkRect2D area) {
+        SetViewport({
+            static_cast<float>(area.offset.x), static_cast<float>(area.offset.y), static_cast<float>(area.extent.width),
+            static_cast<float>(area.extent.height), 0.f, 1.f
+        });
+        SetScissor(area);
+    }
+    void SetLineWidth(float lineWidth) {
+        if (Update(this->lineWidth, lineWidth)) { vkCmdSetLineWidth(handle, lineWidth); }
+    }
+    void SetDepthBias(float constantFactor, float clamp, float slopeFactor) {
+        if (Update(depthBias, std::array{constantFactor, clamp, slopeFactor})) {
+            vkCmdSetDepthBias(handle, constantFactor, clamp, slopeFactor);
+        }
+    }
+    void SetBlendConstants(const float (&blendConstants)[4]) {
+        if (Update(this->blendConstants, std::to_array(blendConstants))) {
+            vkCmdSetBlendConstants(handle, blendConstants);
+        }
+    }
+    // 正面和背面的值分别比较，只录制有变化的面
+    void SetStencilReference(VkStencilFaceFlags faceMask, uint32_t reference) {
+        VkStencilFaceFlags changedFaces = 0;
+        for (uint32_t i = 0; i < 2; i++) {
+            if (!(faceMask & VK_STENCIL_FACE_FRONT_BIT << i)) { continue; }
+            if (stencilReferences[i].first && stencilReferences[i].second == reference) { continue; }
+            stencilReferences[i] = {true, reference};
+            changedFaces |= VK_STENCIL_FACE_FRONT_BIT << i;
+        }
+        if (!changedFaces) {
+            skippedCount++;
+            return;
+        }
+        recordedCount++;
+        vkCmdSetStencilReference(handle, changedFaces, reference);
+    }
+    // 忘记所有已记录的状态，之后的命令均会被录制
+    void Reset() {
+        for (auto& i : bindPoints) { i = {}; }
+        vertexBuffers.clear();
+        indexBuffer = VK_NULL_HANDLE;
+        indexOffset = 0;
+        indexType = VK_INDEX_TYPE_MAX_ENUM;
+        pipelineLayout = VK_NULL_HANDLE;
+        pushConstantData.clear();
+        pushConstantStages.clear();
+        ForgetDynamicStates();
+    }
+    // 改为包装另一个命令缓冲区，已记录的状态被清空，计数保留
+    void Wrap(VkCommandBuffer commandBuffer) {
+        handle = commandBuffer;
+        Reset();
+    }
+    void ResetCounts() { recordedCount = skippedCount = 0; }
+};
+}  // namespace vulkan
@@ -87,12 +87,27 @@ class graphicsBase {
 
     VkDevice device{};
     std::vector<const char*> deviceExtensions{};
+    // 所需的设备特性，创建逻辑设备时只启用这些特性
+    VkPhysicalDeviceFeatures requiredFeatures{};
+    VkPhysicalDeviceVulkan11Features requiredFeatures11{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES};
+    VkPhysicalDeviceVulkan12Features requiredFeatures12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    VkPhysicalDeviceVulkan13Features requiredFeatures13{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
     uint32_t queueFamilyIndex_graphics = VK_QUEUE_FAMILY_IGNORED;
     uint32_t queueFamilyIndex_presentation = VK_QUEUE_FAMILY_IGNORED;
     uint32_t queueFamilyIndex_compute = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t queueFamilyIndex_transfer = VK_QUEUE_FAMILY_IGNORED;
     VkQueue queue_graphics{};
     VkQueue queue_presentation{};
     VkQueue queue_compute{};
+    VkQueue queue_transfer{};
+    // vkQueueSubmit等函数要求对队列进行外部同步，各队列各用一个互斥量，互为同一VkQueue时共用前者的互斥量
+    mutable std::mutex queueMutexes[4];
+
+    // 管线缓存，创建逻辑设备时从文件读取，销毁逻辑设备前写回文件；路径为空时不读写文件
+    VkPipelineCache pipelineCache{};
+    std::string pipelineCachePath = "pipelineCache.bin";
+    // vkMergePipelineCaches要求对目标缓存进行外部同步，合并时独占锁定；以该缓存创建管线时共享锁定
+    mutable std::shared_mutex pipelineCacheMutex;
 
     VkSurfaceKHR surface{};
     std::vector<VkSurfaceFormatKHR> availableSurfaceFormats{};
@@ -110,11 +125,24 @@ class graphicsBase {
     std::vector<void (*)()> callbacks_createDevice;
     std::vector<void (*)()> callbacks_destroyDevice;
 
+    // 由graphicsBase持有的单例，其生存期嵌套在graphicsBase之内，执行销毁逻辑设备的回调时仍然有效
+    std::vector<std::shared_ptr<void>> ownedSingletons;
+    std::mutex ownedSingletonsMutex;
+
     uint32_t currentImageIndex = 0;
 
     /******* private function *********/
 
     graphicsBase() = default;
+
+    // 取得pObject的所有权，在graphicsBase析构时销毁
+    template <typename T>
+    T& Own(T* pObject) {
+        std::lock_guard lock(ownedSingletonsMutex);
+        ownedSingletons.emplace_back(pObject);
+        return *pObject;
+    }
+
     ~graphicsBase() {
         if (!instance) { return; }
         if (device) {
@@ -127,6 +155,11 @@ class graphicsBase {
                 vkDestroySwapchainKHR(device, swapchain, nullptr);
             }
             ExecuteCallbacks(callbacks_destroyDevice);
+            if (pipelineCache) {
+                // 析构器不得抛出异常，转换为VkResult以标记错误已处理，写回失败时SavePipelineCache()已输出错误信息
+                static_cast<VkResult>(SavePipelineCache());
+                vkDestroyPipelineCache(device, pipelineCache, nullptr);
+            }
             vkDestroyDevice(device, nullptr);
         }
         if (surface) { vkDestroySurfaceKHR(instance, surface, nullptr); }
@@ -197,30 +230,30 @@ class graphicsBase {
         if (!queueFamilyCount) return VK_RESULT_MAX_ENUM;
         std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
         vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties.data());
-        // 查找所需的队列簇
-        for (uint32_t i = 0; i < queueFamilyCount; i++) {
-            VkBool32 supportGraphics = queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT,
-                     supportPresentation = false,
-                     supportCompute = queueFamilyProperties[i].queueFlags & VK_QUEUE_COMPUTE_BIT;
-            // 只在创建了window surface 时获取支持呈现的队列簇索引
-            if (surface) {
-                if (VkResult result =
-                        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &supportPresentation)) {
-                    outStream << std::format(
-                        "[ graphicsBase ] ERROR\nFailed to determine if the queue family supports "
-                        "presentation!\nError code: {}\n",
-                        static_cast<int32_t>(result)
-                    );
-                    return result;
-                }
-            }
-            if (supportGraphics && supportCompute && (!surface || supportPresentation)) {
-                queueFamilyIndex_graphics = queueFamilyIndex_compute = i;
-                if (surface) queueFamilyIndex_presentation = i;
-                return VK_SUCCESS;
+        // 只在创建了window surface 时获取各队列簇是否支持呈现
+        std::vector<VkBool32> supportPresentation(surface ? queueFamilyCount : 0);
+        for (uint32_t i = 0; i < supportPresentation.size(); i++) {
+            if (VkResult result =
+                    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &supportPresentation[i])) {
+                outStream << std::format(
+                    "[ graphicsBase ] ERROR\nFailed to determine if the queue family supports "
+                    "presentation!\nError code: {}\n",
+                    static_cast<int32_t>(result)
+                );
+                return result;
             }
         }
-        return VK_RESULT_MAX_ENUM;
+        // 查找所需的队列簇
+        queueFamilySelection selection = SelectQueueFamilies(
+            {queueFamilyProperties.data(), queueFamilyProperties.size()},
+            {supportPresentation.data(), supportPresentation.size()}
+        );
+        if (selection.graphics == VK_QUEUE_FAMILY_IGNORED) { return VK_RESULT_MAX_ENUM; }
+        queueFamilyIndex_graphics = selection.graphics;
+        queueFamilyIndex_presentation = selection.presentation;
+        queueFamilyIndex_compute = selection.compute;
+        queueFamilyIndex_transfer = selection.transfer;
+        return VK_SUCCESS;
     }
 
     result_t CreateSwapchain_Internal() {
@@ -273,11 +306,220 @@ class graphicsBase {
         return VK_SUCCESS;
     }
 
+    // 各特性结构体中全部VkBool32成员的成员指针及名称，检查特性时只遍历这些成员，不越过结构体末尾的填充字节
+    template <typename T>
+    using featureNames = std::span<const std::pair<VkBool32 T::*, const char*>>;
+#define FeatureName(member) std::pair{&features::member, #member}
+    static featureNames<VkPhysicalDeviceFeatures> FeatureNames(const VkPhysicalDeviceFeatures&) {
+        using features = VkPhysicalDeviceFeatures;
+        static constexpr std::pair<VkBool32 features::*, const char*> names[] = {
+            FeatureName(robustBufferAccess), FeatureName(fullDrawIndexUint32), FeatureName(imageCubeArray),
+            FeatureName(independentBlend), FeatureName(geometryShader), FeatureName(tessellationShader),
+            FeatureName(sampleRateShading), FeatureName(dualSrcBlend), FeatureName(logicOp),
+            FeatureName(multiDrawIndirect), FeatureName(drawIndirectFirstInstance), FeatureName(depthClamp),
+            FeatureName(depthBiasClamp), FeatureName(fillModeNonSolid), FeatureName(depthBounds),
+            FeatureName(wideLines), FeatureName(largePoints), FeatureName(alphaToOne), FeatureName(multiViewport),
+            FeatureName(samplerAnisotropy), FeatureName(textureCompressionETC2),
+            FeatureName(textureCompressionASTC_LDR), FeatureName(textureCompressionBC),
+            FeatureName(occlusionQueryPrecise), FeatureName(pipelineStatisticsQuery),
+            FeatureName(vertexPipelineStoresAndAtomics), FeatureName(fragmentStoresAndAtomics),
+            FeatureName(shaderTessellationAndGeometryPointSize), FeatureName(shaderImageGatherExtended),
+            FeatureName(shaderStorageImageExtendedFormats), FeatureName(shaderStorageImageMultisample),
+            FeatureName(shaderStorageImageReadWithoutFormat), FeatureName(shaderStorageImageWriteWithoutFormat),
+            FeatureName(shaderUniformBufferArrayDynamicIndexing), FeatureName(shaderSampledImageArrayDynamicIndexing),
+            FeatureName(shaderStorageBufferArrayDynamicIndexing), FeatureName(shaderStorageImageArrayDynamicIndexing),
+            FeatureName(shaderClipDistance), FeatureName(shaderCullDistance), FeatureName(shaderFloat64),
+            FeatureName(shaderInt64), FeatureName(shaderInt16), FeatureName(shaderResourceResidency),
+            FeatureName(shaderResourceMinLod), FeatureName(sparseBinding), FeatureName(sparseResidencyBuffer),
+            FeatureName(sparseResidencyImage2D), FeatureName(sparseResidencyImage3D),
+            FeatureName(sparseResidency2Samples), FeatureName(sparseResidency4Samples),
+            FeatureName(sparseResidency8Samples), FeatureName(sparseResidency16Samples),
+            FeatureName(sparseResidencyAliased), FeatureName(variableMultisampleRate), FeatureName(inheritedQueries),
+        };
+        return names;
+    }
+    static featureNames<VkPhysicalDeviceVulkan11Features> FeatureNames(const VkPhysicalDeviceVulkan11Features&) {
+        using features = VkPhysicalDeviceVulkan11Features;
+        static constexpr std::pair<VkBool32 features::*, const char*> names[] = {
+            FeatureName(storageBuffer16BitAccess), FeatureName(uniformAndStorageBuffer16BitAccess),
+            FeatureName(storagePushConstant16), FeatureName(storageInputOutput16), FeatureName(multiview),
+            FeatureName(multiviewGeometryShader), FeatureName(multiviewTessellationShader),
+            FeatureName(variablePointersStorageBuffer), FeatureName(variablePointers), FeatureName(protectedMemory),
+            FeatureName(samplerYcbcrConversion), FeatureName(shaderDrawParameters),
+        };
+        return names;
+    }
+    static featureNames<VkPhysicalDeviceVulkan12Features> FeatureNames(const VkPhysicalDeviceVulkan12Features&) {
+        using features = VkPhysicalDeviceVulkan12Features;
+        static constexpr std::pair<VkBool32 features::*, const char*> names[] = {
+            FeatureName(samplerMirrorClampToEdge), FeatureName(drawIndirectCount), FeatureName(storageBuffer8BitAccess),
+            FeatureName(uniformAndStorageBuffer8BitAccess), FeatureName(storagePushConstant8),
+            FeatureName(shaderBufferInt64Atomics), FeatureName(shaderSharedInt64Atomics), FeatureName(shaderFloat16),
+            FeatureName(shaderInt8), FeatureName(descriptorIndexing),
+            FeatureName(shaderInputAttachmentArrayDynamicIndexing),
+            FeatureName(shaderUniformTexelBufferArrayDynamicIndexing),
+            FeatureName(shaderStorageTexelBufferArrayDynamicIndexing),
+            FeatureName(shaderUniformBufferArrayNonUniformIndexing),
+            FeatureName(shaderSampledImageArrayNonUniformIndexing),
+            FeatureName(shaderStorageBufferArrayNonUniformIndexing),
+            FeatureName(shaderStorageImageArrayNonUniformIndexing),
+            FeatureName(shaderInputAttachmentArrayNonUniformIndexing),
+            FeatureName(shaderUniformTexelBufferArrayNonUniformIndexing),
+            FeatureName(shaderStorageTexelBufferArrayNonUniformIndexing),
+            FeatureName(descriptorBindingUniformBufferUpdateAfterBind),
+            FeatureName(descriptorBindingSampledImageUpdateAfterBind),
+            FeatureName(descriptorBindingStorageImageUpdateAfterBind),
+            FeatureName(descriptorBindingStorageBufferUpdateAfterBind),
+            FeatureName(descriptorBindingUniformTexelBufferUpdateAfterBind),
+            FeatureName(descriptorBindingStorageTexelBufferUpdateAfterBind),
+            FeatureName(descriptorBindingUpdateUnusedWhilePending), FeatureName(descriptorBindingPartiallyBound),
+            FeatureName(descriptorBindingVariableDescriptorCount), FeatureName(runtimeDescriptorArray),
+            FeatureName(samplerFilterMinmax), FeatureName(scalarBlockLayout), FeatureName(imagelessFramebuffer),
+            FeatureName(uniformBufferStandardLayout), FeatureName(shaderSubgroupExtendedTypes),
+            FeatureName(separateDepthStencilLayouts), FeatureName(hostQueryReset), FeatureName(timelineSemaphore),
+            FeatureName(bufferDeviceAddress), FeatureName(bufferDeviceAddressCaptureReplay),
+            FeatureName(bufferDeviceAddressMultiDevice), FeatureName(vulkanMemoryModel),
+            FeatureName(vulkanMemoryModelDeviceScope), FeatureName(vulkanMemoryModelAvailabilityVisibilityChains),
+            FeatureName(shaderOutputViewportIndex), FeatureName(shaderOutputLayer),
+            FeatureName(subgroupBroadcastDynamicId),
+        };
+        return names;
+    }
+    static featureNames<VkPhysicalDeviceVulkan13Features> FeatureNames(const VkPhysicalDeviceVulkan13Features&) {
+        using features = VkPhysicalDeviceVulkan13Features;
+        static constexpr std::pair<VkBool32 features::*, const char*> names[] = {
+            FeatureName(robustImageAccess), FeatureName(inlineUniformBlock),
+            FeatureName(descriptorBindingInlineUniformBlockUpdateAfterBind), FeatureName(pipelineCreationCacheControl),
+            FeatureName(privateData), FeatureName(shaderDemoteToHelperInvocation),
+            FeatureName(shaderTerminateInvocation), FeatureName(subgroupSizeControl), FeatureName(computeFullSubgroups),
+            FeatureName(synchronization2), FeatureName(textureCompressionASTC_HDR),
+            FeatureName(shaderZeroInitializeWorkgroupMemory), FeatureName(dynamicRendering),
+            FeatureName(shaderIntegerDotProduct), FeatureName(maintenance4),
+        };
+        return names;
+    }
+#undef FeatureName
+    // 逐一比较FeatureNames(...)中列出的VkBool32成员，输出所需但不支持的特性的名称
+    template <typename T>
+    static bool CheckFeatures(const T& required, const T& supported, const char* structName) {
+        bool allSupported = true;
+        for (auto& [member, name] : FeatureNames(required)) {
+            if (!(required.*member) || supported.*member) { continue; }
+            outStream << std::format(
+                "[ graphicsBase ] ERROR\nA required device feature is not supported: {}::{}\n", structName, name
+            );
+            allSupported = false;
+        }
+        return allSupported;
+    }
+    template <typename T>
+    static bool AnyFeature(const T& features) {
+        return std::ranges::any_of(FeatureNames(features), [&](const auto& i) { return features.*i.first; });
+    }
+
+    // 检查所需的设备特性是否均受支持，并将需要启用的1.1~1.3特性结构体串成pNext链
+    result_t ChainRequiredFeatures(void*& pNext) {
+        // 实际可用的版本取实例与物理设备版本中较低者
+        uint32_t version = std::min(apiVersion, physicalDeviceProperties.apiVersion);
+        bool need11 = AnyFeature(requiredFeatures11);
+        bool need12 = AnyFeature(requiredFeatures12);
+        bool need13 = AnyFeature(requiredFeatures13);
+        if (((need11 || need12) && version < VK_API_VERSION_1_2) || (need13 && version < VK_API_VERSION_1_3)) {
+            outStream << std::format(
+                "[ graphicsBase ] ERROR\nRequired device features need Vulkan {}.{}, but only {}.{} is available!\n", 1,
+                need13 && version < VK_API_VERSION_1_3 ? 3 : 2, VK_API_VERSION_MAJOR(version),
+                VK_API_VERSION_MINOR(version)
+            );
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        VkPhysicalDeviceFeatures supportedFeatures;
+        VkPhysicalDeviceVulkan11Features supportedFeatures11{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES};
+        VkPhysicalDeviceVulkan12Features supportedFeatures12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+        VkPhysicalDeviceVulkan13Features supportedFeatures13{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
+        if (version >= VK_API_VERSION_1_2) {
+            VkPhysicalDeviceFeatures2 features2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &supportedFeatures11};
+            supportedFeatures11.pNext = &supportedFeatures12;
+            if (version >= VK_API_VERSION_1_3) { supportedFeatures12.pNext = &supportedFeatures13; }
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+            supportedFeatures = features2.features;
+        } else {
+            vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+        }
+        bool allSupported = CheckFeatures(requiredFeatures, supportedFeatures, "VkPhysicalDeviceFeatures") &
+                            CheckFeatures(requiredFeatures11, supportedFeatures11, "VkPhysicalDeviceVulkan11Features") &
+                            CheckFeatures(requiredFeatures12, supportedFeatures12, "VkPhysicalDeviceVulkan12Features") &
+                            CheckFeatures(requiredFeatures13, supportedFeatures13, "VkPhysicalDeviceVulkan13Features");
+        if (!allSupported) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+        // 从后往前串起pNext链，只包含有所需特性的结构体
+        pNext = nullptr;
+        if (need13) { requiredFeatures13.pNext = pNext, pNext = &requiredFeatures13; }
+        if (need12) { requiredFeatures12.pNext = pNext, pNext = &requiredFeatures12; }
+        if (need11) { requiredFeatures11.pNext = pNext, pNext = &requiredFeatures11; }
+        return VK_SUCCESS;
+    }
+
+    // 读取管线缓存文件，文件头与当前物理设备不符时丢弃其数据，以空缓存开始
+    std::vector<uint8_t> LoadPipelineCacheData() const {
+        std::vector<uint8_t> data;
+        if (pipelineCachePath.empty()) { return data; }
+        std::ifstream file(pipelineCachePath, std::ios::binary | std::ios::ate);
+        if (!file) { return data; }
+        data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data.data()), data.size());
+        VkPipelineCacheHeaderVersionOne header = {};
+        if (data.size() < sizeof header) {
+            data.clear();
+            return data;
+        }
+        memcpy(&header, data.data(), sizeof header);
+        if (header.headerSize < sizeof header || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            header.vendorID != physicalDeviceProperties.vendorID ||
+            header.deviceID != physicalDeviceProperties.deviceID ||
+            memcmp(header.pipelineCacheUUID, physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE)) {
+            outStream << std::format(
+                "[ graphicsBase ] WARNING\nThe pipeline cache file doesn't match the current device and is ignored!\n"
+            );
+            data.clear();
+        }
+        return data;
+    }
+    result_t CreatePipelineCache() {
+        std::vector<uint8_t> data = LoadPipelineCacheData();
+        VkPipelineCacheCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .initialDataSize = data.size(),
+            .pInitialData = data.data(),
+        };
+        VkResult result = vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache);
+        if (result) {
+            outStream << std::format(
+                "[ graphicsBase ] ERROR\nFailed to create a pipeline cache!\nError code: {}\n",
+                static_cast<int32_t>(result)
+            );
+        }
+        return result;
+    }
+
+    // 加锁后提交，锁只覆盖vkQueueSubmit本身
+    VkResult SubmitToQueue(VkQueue queue, const VkSubmitInfo& submitInfo, VkFence fence) const {
+        std::lock_guard lock(QueueMutex(queue));
+        return vkQueueSubmit(queue, 1, &submitInfo, fence);
+    }
+
     static void ExecuteCallbacks(std::vector<void (*)()> callbacks) {
         for (size_t size = callbacks.size(), i = 0; i < size; i++) { callbacks[i](); }
     }
 
   public:
+    // 所选的各队列簇索引，未选出的为VK_QUEUE_FAMILY_IGNORED
+    struct queueFamilySelection {
+        uint32_t graphics = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t presentation = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t compute = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t transfer = VK_QUEUE_FAMILY_IGNORED;
+    };
+
     // 单例模式，禁止拷贝和移动构造
     graphicsBase(const graphicsBase&) = delete;
     graphicsBase& operator=(const graphicsBase&) = delete;
@@ -289,9 +531,51 @@ class graphicsBase {
         return singleton;
     }
     static graphicsBasePlus& Plus() { return *Base().pPlus; }
+    /*
+     * 取得由graphicsBase持有的T类型单例，第一次调用时创建，线程安全
+     * 函数内的静态对象晚于graphicsBase构造完成，因而先于其析构，不能在销毁逻辑设备的回调中访问，
+     * 注册了这类回调的单例须以此创建；T的默认构造器为私有时，须将graphicsBase声明为友元
+     */
+    template <typename T>
+    static T& OwnedSingleton() {
+        static T& singleton = Base().Own(new T);
+        return singleton;
+    }
     static void Plus(graphicsBasePlus& plus) {
         if (!Base().pPlus) { Base().pPlus = &plus; }
     }
+    /*
+     * 根据队列簇属性选择各队列簇，不访问设备，因而可用伪造的队列簇布局单独验证
+     * supportPresentation为空表示不需要呈现
+     * 图形队列簇须同时支持图形和计算（需要呈现时还须支持呈现），呈现与之共用
+     * 计算优先选择不支持图形的队列簇（异步计算），传输优先选择仅支持传输的队列簇（通常对应DMA引擎），没有时退回图形队列簇
+     */
+    static queueFamilySelection SelectQueueFamilies(
+        arrayRef<const VkQueueFamilyProperties> properties, arrayRef<const VkBool32> supportPresentation
+    ) {
+        queueFamilySelection selection;
+        for (uint32_t i = 0; i < properties.Count(); i++) {
+            VkQueueFlags flags = properties[i].queueFlags;
+            if ((flags & VK_QUEUE_GRAPHICS_BIT) && (flags & VK_QUEUE_COMPUTE_BIT) &&
+                (!supportPresentation.Count() || supportPresentation[i])) {
+                selection.graphics = i;
+                if (supportPresentation.Count()) { selection.presentation = i; }
+                break;
+            }
+        }
+        if (selection.graphics == VK_QUEUE_FAMILY_IGNORED) { return selection; }
+        selection.compute = selection.transfer = selection.graphics;
+        for (uint32_t i = 0; i < properties.Count(); i++) {
+            VkQueueFlags flags = properties[i].queueFlags;
+            if (flags & VK_QUEUE_GRAPHICS_BIT) { continue; }
+            if ((flags & VK_QUEUE_COMPUTE_BIT) && selection.compute == selection.graphics) { selection.compute = i; }
+            if (!(flags & VK_QUEUE_COMPUTE_BIT) && (flags & VK_QUEUE_TRANSFER_BIT) &&
+                selection.transfer == selection.graphics) {
+                selection.transfer = i;
+            }
+        }
+        return selection;
+    }
 
     // Getter
     uint32_t ApiVersion() const { return apiVersion; }
@@ -305,14 +589,17 @@ class graphicsBase {
         return physicalDeviceMemoryProperties;
     }
     VkPhysicalDevice AvailablePhysicalDevice(uint32_t index) const { return availablePhysicalDevices[index]; }
+    uint32_t AvailablePhysicalDeviceCount() const { return static_cast<uint32_t>(availablePhysicalDevices.size()); }
     VkDevice Device() const { return device; }
     const std::vector<const char*>& DeviceExtensions() const { return deviceExtensions; }
     uint32_t QueueFamilyIndex_Graphics() const { return queueFamilyIndex_graphics; }
     uint32_t QueueFamilyIndex_Presentation() const { return queueFamilyIndex_presentation; }
     uint32_t QueueFamilyIndex_Compute() const { return queueFamilyIndex_compute; }
+    uint32_t QueueFamilyIndex_Transfer() const { return queueFamilyIndex_transfer; }
     VkQueue Queue_Graphics() const { return queue_graphics; }
     VkQueue Queue_Presentation() const { return queue_presentation; }
     VkQueue Queue_Compute() const { return queue_compute; }
+    VkQueue Queue_Transfer() const { return queue_transfer; }
     const VkFormat& AvailableSurfaceFormat(const uint32_t index) const { return availableSurfaceFormats[index].format; }
     const VkColorSpaceKHR& AvailableSurfaceColorSpace(const uint32_t index) const {
         return availableSurfaceFormats[index].colorSpace;
@@ -324,6 +611,9 @@ class graphicsBase {
     uint32_t SwapchainImageCount() const { return static_cast<uint32_t>(swapchainImages.size()); }
     const VkSwapchainCreateInfoKHR& SwapchainCreateInfo() const { return swapchainCreateInfo; }
     uint32_t CurrentImageIndex() const { return currentImageIndex; }
+    VkPipelineCache PipelineCache() const { return pipelineCache; }
+    std::shared_mutex& PipelineCacheMutex() const { return pipelineCacheMutex; }
+    const std::string& PipelineCachePath() const { return pipelineCachePath; }
 
     // 添加回调函数
     void AddCallback_CreateSwapchain(void (*function)()) { callbacks_createSwapchain.push_back(function); }
@@ -331,7 +621,18 @@ class graphicsBase {
     void AddCallback_CreateDevice(void (*function)()) { callbacks_createDevice.push_back(function); }
     void AddCallback_DestroyDevice(void (*function)()) { callbacks_destroyDevice.push_back(function); }
 
+    // 取得保护队列的互斥量，在其他线程可能同时使用该队列时，直接调用vkQueue*函数前应先锁定
+    std::mutex& QueueMutex(VkQueue queue) const {
+        VkQueue queues[] = {queue_graphics, queue_compute, queue_presentation, queue_transfer};
+        for (size_t i = 0; i < std::size(queues); i++) {
+            if (queues[i] == queue) { return queueMutexes[i]; }
+        }
+        return queueMutexes[0];
+    }
+
+    // vkDeviceWaitIdle要求对所有队列进行外部同步
     result_t WaitIdle() const {
+        std::scoped_lock lock(queueMutexes[0], queueMutexes[1], queueMutexes[2], queueMutexes[3]);
         VkResult result = vkDeviceWaitIdle(device);
         if (result) {
             outStream << std::format(
@@ -348,6 +649,7 @@ class graphicsBase {
         instance = VK_NULL_HANDLE;
         physicalDevice = VK_NULL_HANDLE;
         device = VK_NULL_HANDLE;
+        pipelineCache = VK_NULL_HANDLE;
         surface = VK_NULL_HANDLE;
         swapchain = VK_NULL_HANDLE;
         swapchainImages.resize(0);
@@ -356,9 +658,67 @@ class graphicsBase {
         debugMessenger = VK_NULL_HANDLE;
     }
 
+    // 设置管线缓存文件的路径，须在创建逻辑设备前调用；设为空字符串则不读写文件
+    void PipelineCachePath(std::string path) { pipelineCachePath = std::move(path); }
+
+    // 将其他线程各自使用的管线缓存合并到共享的管线缓存中，期间以该缓存创建管线的线程会等待合并完成
+    result_t MergePipelineCaches(arrayRef<const VkPipelineCache> srcCaches) const {
+        std::unique_lock lock(pipelineCacheMutex);
+        VkResult result =
+            vkMergePipelineCaches(device, pipelineCache, uint32_t(srcCaches.Count()), srcCaches.Pointer());
+        if (result) {
+            outStream << std::format(
+                "[ graphicsBase ] ERROR\nFailed to merge pipeline caches!\nError code: {}\n",
+                static_cast<int32_t>(result)
+            );
+        }
+        return result;
+    }
+
+    // 将管线缓存写入文件，销毁逻辑设备前会自动调用
+    result_t SavePipelineCache() const {
+        if (!pipelineCache || pipelineCachePath.empty()) { return VK_SUCCESS; }
+        std::shared_lock lock(pipelineCacheMutex);
+        size_t dataSize = 0;
+        VkResult result = vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr);
+        std::vector<uint8_t> data(dataSize);
+        result || (result = vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()));
+        if (result) {
+            outStream << std::format(
+                "[ graphicsBase ] ERROR\nFailed to get the data of the pipeline cache!\nError code: {}\n",
+                static_cast<int32_t>(result)
+            );
+            return result;
+        }
+        std::ofstream file(pipelineCachePath, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(data.data()), dataSize)) {
+            outStream << std::format(
+                "[ graphicsBase ] ERROR\nFailed to write the pipeline cache file: {}\n", pipelineCachePath
+            );
+            return VK_RESULT_MAX_ENUM;
+        }
+        return VK_SUCCESS;
+    }
+
     // 以下函数用于创建Vulkan实例前
     void AddInstanceLayer(const char* layerName) { AddLayerOrExtension(instanceLayers, layerName); }
     void AddInstanceExtension(const char* extensionName) { AddLayerOrExtension(instanceExtensions, extensionName); }
+    // 使用加载器支持的最新Vulkan版本，要启用1.1及以上版本的设备特性时需先调用
+    result_t UseLatestApiVersion() {
+        auto vkEnumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+            vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion")
+        );
+        // 该函数不存在时，加载器只支持Vulkan 1.0
+        if (!vkEnumerateInstanceVersion) { return VK_SUCCESS; }
+        VkResult result = vkEnumerateInstanceVersion(&apiVersion);
+        if (result) {
+            outStream << std::format(
+                "[ graphicsBase ] ERROR\nFailed to get the latest Vulkan API version!\nError code: {}\n",
+                static_cast<int32_t>(result)
+            );
+        }
+        return result;
+    }
 
     // 创建Vulkan实例
     result_t CreateInstance(VkInstanceCreateFlags flags = 0) {
@@ -475,6 +835,18 @@ class graphicsBase {
 
     // 用于创建逻辑设备前
     void AddDeviceExtension(const char* extensionName) { AddLayerOrExtension(deviceExtensions, extensionName); }
+    // 声明所需的设备特性，如RequireDeviceFeature(&VkPhysicalDeviceVulkan12Features::timelineSemaphore)
+    // 未声明的特性一律不启用，VkPhysicalDeviceVulkan11Features和12Features需要Vulkan 1.2，13Features需要Vulkan 1.3
+    void RequireDeviceFeature(VkBool32 VkPhysicalDeviceFeatures::* feature) { requiredFeatures.*feature = VK_TRUE; }
+    void RequireDeviceFeature(VkBool32 VkPhysicalDeviceVulkan11Features::* feature) {
+        requiredFeatures11.*feature = VK_TRUE;
+    }
+    void RequireDeviceFeature(VkBool32 VkPhysicalDeviceVulkan12Features::* feature) {
+        requiredFeatures12.*feature = VK_TRUE;
+    }
+    void RequireDeviceFeature(VkBool32 VkPhysicalDeviceVulkan13Features::* feature) {
+        requiredFeatures13.*feature = VK_TRUE;
+    }
 
     // 获取物理设备
     result_t GetPhysicalDevices() {
@@ -501,22 +873,28 @@ class graphicsBase {
     ) {
         // 定义一个特殊值用于标记一个队列簇索引已被找过但是为找到
         static constexpr uint32_t notFound = INT32_MAX;
-        static std::vector<uint32_t> queueFamilyIndices(availablePhysicalDevices.size());
+        static std::vector<queueFamilySelection> queueFamilySelections(availablePhysicalDevices.size());
+        queueFamilySelection& selection = queueFamilySelections[deviceIndex];
 
-        if (queueFamilyIndices[deviceIndex] == notFound) { return VK_RESULT_MAX_ENUM; }
+        if (selection.graphics == notFound) { return VK_RESULT_MAX_ENUM; }
 
         // 如果队列簇索引被获取但还未被找到
-        if (queueFamilyIndices[deviceIndex] == VK_QUEUE_FAMILY_IGNORED) {
+        if (selection.graphics == VK_QUEUE_FAMILY_IGNORED) {
             VkResult result = GetQueueFamilyIndices(availablePhysicalDevices[deviceIndex]);
             if (result) {
-                if (result == VK_RESULT_MAX_ENUM) { queueFamilyIndices[deviceIndex] = notFound; }
+                if (result == VK_RESULT_MAX_ENUM) { selection.graphics = notFound; }
                 return result;
             } else {
-                queueFamilyIndices[deviceIndex] = queueFamilyIndex_graphics;
+                selection = {
+                    queueFamilyIndex_graphics, queueFamilyIndex_presentation, queueFamilyIndex_compute,
+                    queueFamilyIndex_transfer
+                };
             }
         } else {
-            queueFamilyIndex_graphics = queueFamilyIndex_compute = queueFamilyIndices[deviceIndex];
-            queueFamilyIndex_presentation = surface ? queueFamilyIndices[deviceIndex] : VK_QUEUE_FAMILY_IGNORED;
+            queueFamilyIndex_graphics = selection.graphics;
+            queueFamilyIndex_presentation = selection.presentation;
+            queueFamilyIndex_compute = selection.compute;
+            queueFamilyIndex_transfer = selection.transfer;
         }
 
         physicalDevice = availablePhysicalDevices[deviceIndex];
@@ -526,37 +904,43 @@ class graphicsBase {
     // 创建逻辑设备，并获得队列
     result_t CreateDevice(VkDeviceCreateFlags flags = 0) {
         float queuePriority = 1.0f;
-        VkDeviceQueueCreateInfo queueCreateInfos[3] = {
-            {.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, .queueCount = 1, .pQueuePriorities = &queuePriority},
-            {.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, .queueCount = 1, .pQueuePriorities = &queuePriority},
-            {.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, .queueCount = 1, .pQueuePriorities = &queuePriority}
-        };
+        VkDeviceQueueCreateInfo queueCreateInfos[4] = {};
         uint32_t queueCreateInfoCount = 0;
-        if (queueFamilyIndex_graphics != VK_QUEUE_FAMILY_IGNORED) {
-            queueCreateInfos[queueCreateInfoCount++].queueFamilyIndex = queueFamilyIndex_graphics;
-        }
-        if (queueFamilyIndex_presentation != VK_QUEUE_FAMILY_IGNORED &&
-            queueFamilyIndex_presentation != queueFamilyIndex_graphics) {
-            queueCreateInfos[queueCreateInfoCount++].queueFamilyIndex = queueFamilyIndex_presentation;
-        }
-        if (queueFamilyIndex_compute != VK_QUEUE_FAMILY_IGNORED &&
-            queueFamilyIndex_compute != queueFamilyIndex_graphics &&
-            queueFamilyIndex_compute != queueFamilyIndex_presentation) {
-            queueCreateInfos[queueCreateInfoCount++].queueFamilyIndex = queueFamilyIndex_compute;
+        // 每个不同的队列簇各创建一个队列
+        for (uint32_t queueFamilyIndex :
+             {queueFamilyIndex_graphics, queueFamilyIndex_presentation, queueFamilyIndex_compute,
+              queueFamilyIndex_transfer}) {
+            if (queueFamilyIndex == VK_QUEUE_FAMILY_IGNORED) { continue; }
+            bool added = false;
+            for (uint32_t i = 0; i < queueCreateInfoCount; i++) {
+                added |= queueCreateInfos[i].queueFamilyIndex == queueFamilyIndex;
+            }
+            if (added) { continue; }
+            queueCreateInfos[queueCreateInfoCount++] = {
+                .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                .queueFamilyIndex = queueFamilyIndex,
+                .queueCount = 1,
+                .pQueuePriorities = &queuePriority
+            };
         }
 
-        // 获取物理设备特性
-        VkPhysicalDeviceFeatures physicalDeviceFeatures;
-        vkGetPhysicalDeviceFeatures(physicalDevice, &physicalDeviceFeatures);
+        // 获取物理设备属性和内存属性
+        vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &physicalDeviceMemoryProperties);
+
+        // 只启用所需的设备特性，并检查其是否均受支持
+        void* pNext = nullptr;
+        if (VkResult result = ChainRequiredFeatures(pNext)) { return result; }
 
         VkDeviceCreateInfo deviceCreateInfo = {
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            .pNext = pNext,
             .flags = flags,
             .queueCreateInfoCount = queueCreateInfoCount,
             .pQueueCreateInfos = queueCreateInfos,
             .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
             .ppEnabledExtensionNames = deviceExtensions.data(),
-            .pEnabledFeatures = &physicalDeviceFeatures,
+            .pEnabledFeatures = &requiredFeatures,
         };
 
         if (VkResult result = vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device)) {
@@ -577,10 +961,12 @@ class graphicsBase {
         if (queueFamilyIndex_compute != VK_QUEUE_FAMILY_IGNORED) {
             vkGetDeviceQueue(device, queueFamilyIndex_compute, 0, &queue_compute);
         }
+        if (queueFamilyIndex_transfer != VK_QUEUE_FAMILY_IGNORED) {
+            vkGetDeviceQueue(device, queueFamilyIndex_transfer, 0, &queue_transfer);
+        }
 
-        // 获取物理设备属性和内存属性
-        vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
-        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &physicalDeviceMemoryProperties);
+        // 管线缓存创建失败不影响后续使用，pipeline::Create(...)会在不使用缓存的情况下创建管线
+        if (VkResult result = CreatePipelineCache()) { pipelineCache = VK_NULL_HANDLE; }
         // 输出所选物理设备的名称
         outStream << std::format("Renderer: {}\n", physicalDeviceProperties.deviceName);
         ExecuteCallbacks(callbacks_createDevice);
@@ -773,9 +1159,16 @@ class graphicsBase {
         swapchainCreateInfo.imageExtent = surfaceCapabilities.currentExtent;
         swapchainCreateInfo.oldSwapchain = swapchain;
 
-        VkResult result = vkQueueWaitIdle(queue_graphics);
+        VkResult result = VK_SUCCESS;
+        {
+            std::lock_guard lock(QueueMutex(queue_graphics));
+            result = vkQueueWaitIdle(queue_graphics);
+        }
         // 仅在等待图形队列成功，且图形与呈现所用队列不同时等待呈现队列
-        if (!result && queue_graphics != queue_presentation) { result = vkQueueWaitIdle(queue_presentation); }
+        if (!result && queue_graphics != queue_presentation) {
+            std::lock_guard lock(QueueMutex(queue_presentation));
+            result = vkQueueWaitIdle(queue_presentation);
+        }
         if (result) {
             outStream << std::format(
                 "[ graphicsBase ] ERROR\nFailed to wait for the queue to be idle!\nError code: "
@@ -826,9 +1219,10 @@ class graphicsBase {
     }
 
     // 提交命令缓冲区到图形队列，需要自定义同步
+    // 各Submit函数内部对队列加锁，可从任意线程调用；命令缓冲区的录制不受此锁影响
     result_t SubmitCommandBuffer_Graphics(VkSubmitInfo& submitInfo, VkFence fence = VK_NULL_HANDLE) const {
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        VkResult result = vkQueueSubmit(queue_graphics, 1, &submitInfo, fence);
+        VkResult result = SubmitToQueue(queue_graphics, submitInfo, fence);
         if (result) {
             outStream << std::format(
                 "[ graphicsBase ] ERROR\nFailed to submit the command buffer!\nError code: {}\n",
@@ -869,7 +1263,7 @@ class graphicsBase {
     // 提交命令缓冲区到计算队列，需要自定义同步
     result_t SubmitCommandBuffer_Compute(VkSubmitInfo& submitInfo, VkFence fence = VK_NULL_HANDLE) const {
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        VkResult result = vkQueueSubmit(queue_compute, 1, &submitInfo, fence);
+        VkResult result = SubmitToQueue(queue_compute, submitInfo, fence);
         if (result) {
             outStream << std::format(
                 "[ graphicsBase ] ERROR\nFailed to submit the command buffer!\nError code: {}\n",
@@ -885,9 +1279,35 @@ class graphicsBase {
         return SubmitCommandBuffer_Compute(submitInfo, fence);
     }
 
+    // 提交命令缓冲区到传输队列，需要自定义同步
+    // 若传输队列簇与使用资源的队列簇不同，对独占（VK_SHARING_MODE_EXCLUSIVE）的资源需自行转移队列簇所有权
+    result_t SubmitCommandBuffer_Transfer(VkSubmitInfo& submitInfo, VkFence fence = VK_NULL_HANDLE) const {
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        VkResult result = SubmitToQueue(queue_transfer, submitInfo, fence);
+        if (result) {
+            outStream << std::format(
+                "[ graphicsBase ] ERROR\nFailed to submit the command buffer!\nError code: {}\n",
+                static_cast<int32_t>(result)
+            );
+        }
+        return result;
+    }
+
+    // 提交命令缓冲区到传输队列,只使用栅栏
+    result_t SubmitCommandBuffer_Transfer(VkCommandBuffer commandBuffer, VkFence fence = VK_NULL_HANDLE) const {
+        VkSubmitInfo submitInfo = {.commandBufferCount = 1, .pCommandBuffers = &commandBuffer};
+        return SubmitCommandBuffer_Transfer(submitInfo, fence);
+    }
+
     result_t PresentImage(VkPresentInfoKHR& presentInfo) {
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-        switch (VkResult result = vkQueuePresentKHR(queue_presentation, &presentInfo)) {
+        VkResult result = VK_SUCCESS;
+        {
+            // 重建交换链时会等待队列空闲，须在此之前解锁
+            std::lock_guard lock(QueueMutex(queue_presentation));
+            result = vkQueuePresentKHR(queue_presentation, &presentInfo);
+        }
+        switch (result) {
             case VK_SUCCESS:
                 return VK_SUCCESS;
             case VK_SUBOPTIMAL_KHR:
@@ -1110,6 +1530,17 @@ class commandPool {
         memset(buffers.Pointer(), 0, buffers.Count() * sizeof(VkCommandBuffer));
     }
     void FreeBuffers(arrayRef<commandBuffer> buffers) const { FreeBuffers({&buffers[0].handle, buffers.Count()}); }
+    // 一次性重置池中所有命令缓冲区，调用前需确保其均已执行完毕
+    result_t Reset(VkCommandPoolResetFlags flags = 0) const {
+        VkResult result = vkResetCommandPool(graphicsBase::Base().Device(), handle, flags);
+        if (result) {
+            outStream << std::format(
+                "[ commandPool ] ERROR\nFailed to reset the command pool!\nError code: {}\n",
+                static_cast<int32_t>(result)
+            );
+        }
+        return result;
+    }
     // Non-const function
     result_t Create(VkCommandPoolCreateInfo& createInfo) {
         createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -1140,6 +1571,7 @@ class renderPass {
     DefineHandleTypeOperator;
     DefineAddressFunction;
     // Const function
+    // 内联录制时，顺带将动态视口和裁剪范围设置为渲染区域
     void CmdBegin(
         VkCommandBuffer commandBuffer, VkRenderPassBeginInfo& beginInfo,
         VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE
@@ -1147,6 +1579,9 @@ class renderPass {
         beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         beginInfo.renderPass = handle;
         vkCmdBeginRenderPass(commandBuffer, &beginInfo, subpassContents);
+        if (subpassContents == VK_SUBPASS_CONTENTS_INLINE) {
+            CmdSetViewportAndScissor(commandBuffer, beginInfo.renderArea);
+        }
     }
     void CmdBegin(
         VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkRect2D renderArea,
@@ -1161,6 +1596,16 @@ class renderPass {
             .pClearValues = clearValues.Pointer()
         };
         vkCmdBeginRenderPass(commandBuffer, &beginInfo, subpassContents);
+        if (subpassContents == VK_SUBPASS_CONTENTS_INLINE) { CmdSetViewportAndScissor(commandBuffer, renderArea); }
+    }
+    // 设置动态视口和裁剪范围，二级命令缓冲区中需自行调用
+    static void CmdSetViewportAndScissor(VkCommandBuffer commandBuffer, VkRect2D area) {
+        VkViewport viewport = {
+            static_cast<float>(area.offset.x), static_cast<float>(area.offset.y), static_cast<float>(area.extent.width),
+            static_cast<float>(area.extent.height), 0.f, 1.f
+        };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &area);
     }
     static void CmdNext(VkCommandBuffer commandBuffer, VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE) {
         vkCmdNextSubpass(commandBuffer, subpassContents);
@@ -1203,6 +1648,80 @@ class framebuffer {
     }
 };
 
+/**
+ * 特化常量，持有映射条目及常量数据
+ * Address()所返回的VkSpecializationInfo在对象存续且未被修改期间有效，复制后副本指向自己的数据
+ */
+class specializationInfo {
+    std::vector<VkSpecializationMapEntry> mapEntries;
+    std::vector<uint8_t> data;
+    VkSpecializationInfo info = {};
+
+    void UpdateInfo() {
+        info = {
+            .mapEntryCount = static_cast<uint32_t>(mapEntries.size()),
+            .pMapEntries = mapEntries.data(),
+            .dataSize = data.size(),
+            .pData = data.data()
+        };
+    }
+
+  public:
+    specializationInfo() = default;
+    specializationInfo(const specializationInfo& other) : mapEntries(other.mapEntries), data(other.data) {
+        UpdateInfo();
+    }
+    specializationInfo(specializationInfo&& other) noexcept
+        : mapEntries(std::move(other.mapEntries)), data(std::move(other.data)) {
+        UpdateInfo();
+        other.UpdateInfo();
+    }
+    specializationInfo& operator=(specializationInfo other) noexcept {
+        mapEntries = std::move(other.mapEntries);
+        data = std::move(other.data);
+        UpdateInfo();
+        return *this;
+    }
+    // Getter
+    bool Empty() const { return mapEntries.empty(); }
+    // 无特化常量时返回nullptr，可直接用于VkPipelineShaderStageCreateInfo::pSpecializationInfo
+    const VkSpecializationInfo* Address() const { return mapEntries.empty() ? nullptr : &info; }
+    // Non-const function
+    // 添加一个特化常量，bool被转为VkBool32，与GLSL中的布尔型特化常量一致；重复的constantID覆盖先前的值
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    specializationInfo& Constant(uint32_t constantId, T value) {
+        if constexpr (std::same_as<T, bool>) {
+            return Constant(constantId, VkBool32(value));
+        } else {
+            auto iterator = std::ranges::find(mapEntries, constantId, &VkSpecializationMapEntry::constantID);
+            if (iterator != mapEntries.end() && iterator->size == sizeof value) {
+                memcpy(data.data() + iterator->offset, &value, sizeof value);
+                return *this;
+            }
+            if (iterator != mapEntries.end()) { mapEntries.erase(iterator); }
+            mapEntries.emplace_back(constantId, static_cast<uint32_t>(data.size()), sizeof value);
+            auto pValue = reinterpret_cast<const uint8_t*>(&value);
+            data.insert(data.end(), pValue, pValue + sizeof value);
+            UpdateInfo();
+            return *this;
+        }
+    }
+    // Static function
+    /**
+     * 由结构体及其成员指针生成特化常量，constantID自firstConstantId起按成员指针的顺序递增，例如
+     * struct variant { uint32_t instanceCount; bool unrolled; };
+     * specializationInfo::From<&variant::instanceCount, &variant::unrolled>(variant{3, true});
+     */
+    template <auto... members, typename T>
+    static specializationInfo From(const T& constants, uint32_t firstConstantId = 0) {
+        specializationInfo specialization;
+        uint32_t constantId = firstConstantId;
+        (specialization.Constant(constantId++, constants.*members), ...);
+        return specialization;
+    }
+};
+
 class shaderModule {
     VkShaderModule handle = VK_NULL_HANDLE;
 
@@ -1230,6 +1749,14 @@ class shaderModule {
             nullptr                                               // pSpecializationInfo
         };
     }
+    // specialization须在管线创建完成前保持有效
+    VkPipelineShaderStageCreateInfo StageCreateInfo(
+        VkShaderStageFlagBits stage, const specializationInfo& specialization, const char* entry = "main"
+    ) const {
+        VkPipelineShaderStageCreateInfo stageCreateInfo = StageCreateInfo(stage, entry);
+        stageCreateInfo.pSpecializationInfo = specialization.Address();
+        return stageCreateInfo;
+    }
     // Non-const function
     result_t Create(VkShaderModuleCreateInfo& createInfo) {
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -1303,8 +1830,10 @@ class pipeline {
     // Non-const function
     result_t Create(VkGraphicsPipelineCreateInfo& createInfo) {
         createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        VkResult result =
-            vkCreateGraphicsPipelines(graphicsBase::Base().Device(), VK_NULL_HANDLE, 1, &createInfo, nullptr, &handle);
+        std::shared_lock lock(graphicsBase::Base().PipelineCacheMutex());
+        VkResult result = vkCreateGraphicsPipelines(
+            graphicsBase::Base().Device(), graphicsBase::Base().PipelineCache(), 1, &createInfo, nullptr, &handle
+        );
         if (result) {
             outStream << std::format(
                 "[ pipeline ] ERROR\nFailed to create a graphics pipeline!\nError code: {}\n",
@@ -1315,8 +1844,10 @@ class pipeline {
     }
     result_t Create(VkComputePipelineCreateInfo& createInfo) {
         createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-        VkResult result =
-            vkCreateComputePipelines(graphicsBase::Base().Device(), VK_NULL_HANDLE, 1, &createInfo, nullptr, &handle);
+        std::shared_lock lock(graphicsBase::Base().PipelineCacheMutex());
+        VkResult result = vkCreateComputePipelines(
+            graphicsBase::Base().Device(), graphicsBase::Base().PipelineCache(), 1, &createInfo, nullptr, &handle
+        );
         if (result) {
             outStream << std::format(
                 "[ pipeline ] ERROR\nFailed to create a compute pipeline!\nError code: {}\n",
@@ -1327,11 +1858,220 @@ class pipeline {
     }
 };
 
+/**
+ * 设备内存子分配器
+ * 每种内存类型维护若干大块VkDeviceMemory，从中划分出对齐的区间交给bufferMemory或imageMemory，
+ * 避免每个对象都调用一次vkAllocateMemory（受maxMemoryAllocationCount限制，且分配本身很慢）
+ * 空闲区间按起始偏移排序，首次适配，释放时与相邻空闲区间合并
+ */
+class deviceMemoryAllocator {
+  public:
+    struct block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void* pMappedData = nullptr;  // host visible的块在创建时整块映射，块内所有子分配共享该映射
+        uint32_t memoryTypeIndex = 0;
+        bool forImages = false;
+        std::map<VkDeviceSize, VkDeviceSize> freeRanges;   // 空闲区间：起始偏移 -> 大小
+        std::map<VkDeviceSize, VkDeviceSize> allocations;  // 已分配区间：起始偏移 -> 大小
+    };
+
+  private:
+    // blocks[memoryTypeIndex][0]供缓冲区使用，blocks[memoryTypeIndex][1]供图像使用
+    std::vector<std::unique_ptr<block>> blocks[VK_MAX_MEMORY_TYPES][2];
+    VkDeviceSize preferredBlockSize = 64ull << 20;
+    uint32_t allocationCount = 0;
+    // 每次随逻辑设备释放所有块时递增，分配时记录，释放时不符说明所在的块已不存在
+    uint64_t generation = 0;
+    mutable std::mutex mutex;
+
+    // 由graphicsBase持有，见graphicsBase::OwnedSingleton()
+    friend class graphicsBase;
+    deviceMemoryAllocator() {
+        graphicsBase::Base().AddCallback_DestroyDevice([] {
+            graphicsBase::OwnedSingleton<deviceMemoryAllocator>().FreeAllBlocks();
+        });
+    }
+
+    static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // 块大小不超过所在堆的1/8，以免小显存设备上一次占用过多
+    VkDeviceSize BlockSize(uint32_t memoryTypeIndex) const {
+        auto& memoryProperties = graphicsBase::Base().PhysicalDeviceMemoryProperties();
+        VkDeviceSize heapSize =
+            memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+        return std::min(preferredBlockSize, heapSize / 8);
+    }
+
+    static bool AllocateFromBlock(block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+        for (auto i = block.freeRanges.begin(); i != block.freeRanges.end(); i++) {
+            auto [rangeOffset, rangeSize] = *i;
+            VkDeviceSize alignedOffset = AlignUp(rangeOffset, alignment);
+            if (alignedOffset + size > rangeOffset + rangeSize) { continue; }
+            block.freeRanges.erase(i);
+            // 对齐前后剩余的部分放回空闲列表
+            if (alignedOffset > rangeOffset) { block.freeRanges.emplace(rangeOffset, alignedOffset - rangeOffset); }
+            if (alignedOffset + size < rangeOffset + rangeSize) {
+                block.freeRanges.emplace(alignedOffset + size, rangeOffset + rangeSize - alignedOffset - size);
+            }
+            block.allocations.emplace(alignedOffset, size);
+            offset = alignedOffset;
+            return true;
+        }
+        return false;
+    }
+
+    block* CreateBlock(uint32_t memoryTypeIndex, bool forImages) {
+        auto pBlock = std::make_unique<block>();
+        pBlock->size = BlockSize(memoryTypeIndex);
+        pBlock->memoryTypeIndex = memoryTypeIndex;
+        pBlock->forImages = forImages;
+        VkMemoryAllocateInfo allocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = pBlock->size,
+            .memoryTypeIndex = memoryTypeIndex,
+        };
+        if (VkResult result =
+                vkAllocateMemory(graphicsBase::Base().Device(), &allocateInfo, nullptr, &pBlock->memory)) {
+            outStream << std::format(
+                "[ deviceMemoryAllocator ] ERROR\nFailed to allocate a memory block!\nError code: {}\n",
+                static_cast<int32_t>(result)
+            );
+            return nullptr;
+        }
+        if (graphicsBase::Base().PhysicalDeviceMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags &
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (VkResult result = vkMapMemory(
+                    graphicsBase::Base().Device(), pBlock->memory, 0, VK_WHOLE_SIZE, 0, &pBlock->pMappedData
+                )) {
+                outStream << std::format(
+                    "[ deviceMemoryAllocator ] ERROR\nFailed to map a memory block!\nError code: {}\n",
+                    static_cast<int32_t>(result)
+                );
+                vkFreeMemory(graphicsBase::Base().Device(), pBlock->memory, nullptr);
+                return nullptr;
+            }
+        }
+        pBlock->freeRanges.emplace(0, pBlock->size);
+        return blocks[memoryTypeIndex][forImages].emplace_back(std::move(pBlock)).get();
+    }
+
+    void FreeAllBlocks() {
+        std::lock_guard lock(mutex);
+        for (auto& blocksOfType : blocks) {
+            for (auto& blockList : blocksOfType) {
+                for (auto& i : blockList) { vkFreeMemory(graphicsBase::Base().Device(), i->memory, nullptr); }
+                blockList.clear();
+            }
+        }
+        allocationCount = 0;
+        generation++;
+    }
+
+  public:
+    deviceMemoryAllocator(const deviceMemoryAllocator&) = delete;
+    deviceMemoryAllocator& operator=(const deviceMemoryAllocator&) = delete;
+    static deviceMemoryAllocator& Get() { return graphicsBase::OwnedSingleton<deviceMemoryAllocator>(); }
+    // Getter
+    VkDeviceSize PreferredBlockSize() const { return preferredBlockSize; }
+    uint32_t AllocationCount() const {
+        std::lock_guard lock(mutex);
+        return allocationCount;
+    }
+    uint32_t BlockCount() const {
+        std::lock_guard lock(mutex);
+        uint32_t count = 0;
+        for (auto& blocksOfType : blocks) {
+            for (auto& blockList : blocksOfType) { count += static_cast<uint32_t>(blockList.size()); }
+        }
+        return count;
+    }
+    // Setter，只影响此后新建的块
+    void PreferredBlockSize(VkDeviceSize size) { preferredBlockSize = size; }
+
+    /**
+     * 从块中分配一段区间，成功时返回所在的块，返回nullptr表示应退回到独立分配
+     * size：所需大小，会被改写为实际占用的大小
+     * offset：输出分配到的区间在块中的偏移
+     * generation：输出块的代数，释放时原样传给Free(...)
+     * 图像的起始和大小均按bufferImageGranularity对齐，使其与相邻的任何资源不共用一页；
+     * 非一致内存按nonCoherentAtomSize对齐，使flush/invalidate不会越界到相邻分配
+     */
+    block* Allocate(
+        uint32_t memoryTypeIndex, bool forImage, VkDeviceSize& size, VkDeviceSize alignment, VkDeviceSize& offset,
+        uint64_t& generation
+    ) {
+        const VkPhysicalDeviceLimits& limits = graphicsBase::Base().PhysicalDeviceProperties().limits;
+        VkMemoryPropertyFlags memoryProperties =
+            graphicsBase::Base().PhysicalDeviceMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags;
+        if (forImage) {
+            alignment = std::max(alignment, limits.bufferImageGranularity);
+            size = AlignUp(size, limits.bufferImageGranularity);
+        }
+        if ((memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+            !(memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            alignment = std::max(alignment, limits.nonCoherentAtomSize);
+            size = AlignUp(size, limits.nonCoherentAtomSize);
+        }
+        // 大对象单独分配更划算
+        if (size > BlockSize(memoryTypeIndex) / 2) { return nullptr; }
+
+        std::lock_guard lock(mutex);
+        generation = this->generation;
+        for (auto& i : blocks[memoryTypeIndex][forImage]) {
+            if (AllocateFromBlock(*i, size, alignment, offset)) {
+                allocationCount++;
+                return i.get();
+            }
+        }
+        block* pBlock = CreateBlock(memoryTypeIndex, forImage);
+        if (!pBlock || !AllocateFromBlock(*pBlock, size, alignment, offset)) { return nullptr; }
+        allocationCount++;
+        return pBlock;
+    }
+
+    // 归还区间并与相邻的空闲区间合并，块完全空闲且不是该类型最后一块时释放之
+    // 块已随逻辑设备一同释放时（generation不符），什么也不做
+    void Free(block* pBlock, VkDeviceSize offset, uint64_t generation) {
+        std::lock_guard lock(mutex);
+        if (generation != this->generation) { return; }
+        auto allocation = pBlock->allocations.find(offset);
+        if (allocation == pBlock->allocations.end()) { return; }
+        VkDeviceSize size = allocation->second;
+        pBlock->allocations.erase(allocation);
+        allocationCount--;
+
+        auto next = pBlock->freeRanges.lower_bound(offset);
+        if (next != pBlock->freeRanges.end() && offset + size == next->first) {
+            size += next->second;
+            next = pBlock->freeRanges.erase(next);
+        }
+        auto prev = next == pBlock->freeRanges.begin() ? pBlock->freeRanges.end() : std::prev(next);
+        if (prev != pBlock->freeRanges.end() && prev->first + prev->second == offset) {
+            prev->second += size;
+        } else {
+            pBlock->freeRanges.emplace_hint(next, offset, size);
+        }
+
+        auto& blockList = blocks[pBlock->memoryTypeIndex][pBlock->forImages];
+        if (pBlock->allocations.empty() && blockList.size() > 1) {
+            vkFreeMemory(graphicsBase::Base().Device(), pBlock->memory, nullptr);
+            std::erase_if(blockList, [pBlock](const auto& i) { return i.get() == pBlock; });
+        }
+    }
+};
+
 // 设备内存的封装类
 class deviceMemory {
     VkDeviceMemory handle = VK_NULL_HANDLE;
     VkDeviceSize allocationSize = 0;             // 实际会分配的内存大小
     VkMemoryPropertyFlags memoryProperties = 0;  // 内存属性
+    VkDeviceSize memoryOffset = 0;               // 子分配时，该段内存在所在块中的偏移
+    deviceMemoryAllocator::block* pBlock = nullptr;  // 子分配时所在的块，独立分配时为nullptr
+    uint64_t blockGeneration = 0;                    // 子分配时所在的块的代数
+    void* pMappedData = nullptr;  // 持久映射时指向该段内存开头，子分配的内存总是持久映射的
 
     /**
      * 调整非一致内存访问（non-coherent memory）的映射范围，Vulkan要求必须以固定字节对齐的方式访问
@@ -1351,14 +2091,24 @@ class deviceMemory {
         // 将offset向下对齐，rangeEnd向上对齐
         offset = offset / nonCoherentAtomSize * nonCoherentAtomSize;
         rangeEnd = (rangeEnd + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
-        // 确保rangeEnd不超过实际分配的内存大小
-        rangeEnd = std::min(rangeEnd, allocationSize);
+        // 确保rangeEnd不超过实际分配的内存大小（子分配时offset已是块内偏移）
+        rangeEnd = std::min(rangeEnd, memoryOffset + allocationSize);
         // 重新计算size（现在offset和rangeEnd都满足对齐要求）
         size = rangeEnd - offset;
         // 返回调整后的偏移量差值
         return _offset - offset;
     }
 
+    // 将相对于本段内存的范围调整为可直接用于flush/invalidate的范围
+    void FillMappedMemoryRanges(arrayRef<VkMappedMemoryRange> ranges) const {
+        for (auto& i : ranges) {
+            i.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            i.memory = handle;
+            i.offset += memoryOffset;
+            AdjustNonCoherentMemoryRange(i.size, i.offset);
+        }
+    }
+
   protected:
     // 用于bufferMemory或imageMemory,定义于此能节省八个字节
     class {
@@ -1379,27 +2129,51 @@ class deviceMemory {
         MoveHandle;
         allocationSize = other.allocationSize;
         memoryProperties = other.memoryProperties;
+        memoryOffset = other.memoryOffset;
+        pBlock = other.pBlock;
+        blockGeneration = other.blockGeneration;
+        pMappedData = other.pMappedData;
         other.allocationSize = 0;
         other.memoryProperties = 0;
+        other.memoryOffset = 0;
+        other.pBlock = nullptr;
+        other.pMappedData = nullptr;
     }
     ~deviceMemory() {
+        // 子分配的内存只归还区间，块由deviceMemoryAllocator释放
+        if (pBlock) {
+            deviceMemoryAllocator::Get().Free(pBlock, memoryOffset, blockGeneration);
+            pBlock = nullptr;
+            handle = VK_NULL_HANDLE;
+        }
+        // vkFreeMemory会隐式取消映射
         DestroyHandleBy(vkFreeMemory);
         allocationSize = 0;
         memoryProperties = 0;
+        memoryOffset = 0;
+        pMappedData = nullptr;
     }
     // Getter
     DefineHandleTypeOperator;
     DefineAddressFunction;
     VkDeviceSize AllocationSize() const { return allocationSize; }
     VkMemoryPropertyFlags MemoryProperties() const { return memoryProperties; }
+    VkDeviceSize MemoryOffset() const { return memoryOffset; }
+    bool IsSubAllocated() const { return pBlock; }
+    bool IsPersistentlyMapped() const { return pMappedData; }
+    void* MappedData() const { return pMappedData; }
     // Const function
     // 映射host visible的内存区,在对其进行映射（map）后，可以由CPU侧对其进行直接读写
+    // 已持久映射的内存只需计算指针，不调用vkMapMemory
     result_t MapMemory(void*& pData, VkDeviceSize size, VkDeviceSize offset = 0) const {
         VkDeviceSize inverseDeltaOffset{};
+        offset += memoryOffset;
         if (!(memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
             inverseDeltaOffset = AdjustNonCoherentMemoryRange(size, offset);
         }
-        if (VkResult result = vkMapMemory(graphicsBase::Base().Device(), handle, offset, size, 0, &pData)) {
+        if (pMappedData) {
+            pData = static_cast<uint8_t*>(pMappedData) + (offset - memoryOffset);
+        } else if (VkResult result = vkMapMemory(graphicsBase::Base().Device(), handle, offset, size, 0, &pData)) {
             outStream << std::format(
                 "[ deviceMemory ] ERROR\nFailed to map the memory!\nError code: {}\n", int32_t(result)
             );
@@ -1426,6 +2200,7 @@ class deviceMemory {
 
     // 取消映射host visible的内存区
     result_t UnmapMemory(VkDeviceSize size, VkDeviceSize offset = 0) const {
+        offset += memoryOffset;
         if (!(memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
             AdjustNonCoherentMemoryRange(size, offset);
             VkMappedMemoryRange mappedMemoryRange = {
@@ -1439,10 +2214,41 @@ class deviceMemory {
                 return result;
             }
         }
-        vkUnmapMemory(graphicsBase::Base().Device(), handle);
+        if (!pMappedData) { vkUnmapMemory(graphicsBase::Base().Device(), handle); }
         return VK_SUCCESS;
     }
 
+    /**
+     * 批量flush多段写入过的范围，只调用一次vkFlushMappedMemoryRanges，一致内存直接返回
+     * ranges中的offset和size相对于本段内存，由此函数按nonCoherentAtomSize调整并填写sType和memory
+     */
+    result_t FlushRanges(arrayRef<VkMappedMemoryRange> ranges) const {
+        if (memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT || !ranges.Count()) { return VK_SUCCESS; }
+        FillMappedMemoryRanges(ranges);
+        VkResult result =
+            vkFlushMappedMemoryRanges(graphicsBase::Base().Device(), uint32_t(ranges.Count()), ranges.Pointer());
+        if (result) {
+            outStream << std::format(
+                "[ deviceMemory ] ERROR\nFailed to flush the memory!\nError code: {}\n", static_cast<int32_t>(result)
+            );
+        }
+        return result;
+    }
+    // 批量invalidate多段将要读取的范围，参数同FlushRanges(...)
+    result_t InvalidateRanges(arrayRef<VkMappedMemoryRange> ranges) const {
+        if (memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT || !ranges.Count()) { return VK_SUCCESS; }
+        FillMappedMemoryRanges(ranges);
+        VkResult result =
+            vkInvalidateMappedMemoryRanges(graphicsBase::Base().Device(), uint32_t(ranges.Count()), ranges.Pointer());
+        if (result) {
+            outStream << std::format(
+                "[ deviceMemory ] ERROR\nFailed to invalidate the mapped memory range!\nError code: {}\n",
+                static_cast<int32_t>(result)
+            );
+        }
+        return result;
+    }
+
     /**
      * 将CPU内存中的数据复制到GPU的缓冲区需要先映射设备内存，然后使用memcpy进行数据传输，最后取消映射设备内存
      * pData_src：指向源数据的指针,CPU端
@@ -1465,6 +2271,21 @@ class deviceMemory {
     }
 
     // Non-const function
+    // 持久映射：整段映射一次并保留指针直至释放，此后MapMemory/BufferData/RetrieveData不再映射和取消映射
+    result_t PersistentlyMap() {
+        if (pMappedData) { return VK_SUCCESS; }
+        if (!(memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+            outStream << std::format("[ deviceMemory ] ERROR\nOnly host visible memory can be mapped!\n");
+            return VK_RESULT_MAX_ENUM;
+        }
+        if (VkResult result = vkMapMemory(graphicsBase::Base().Device(), handle, 0, VK_WHOLE_SIZE, 0, &pMappedData)) {
+            outStream << std::format(
+                "[ deviceMemory ] ERROR\nFailed to map the memory!\nError code: {}\n", int32_t(result)
+            );
+            return result;
+        }
+        return VK_SUCCESS;
+    }
     result_t Allocate(VkMemoryAllocateInfo& allocateInfo) {
         if (allocateInfo.memoryTypeIndex >= graphicsBase::Base().PhysicalDeviceMemoryProperties().memoryTypeCount) {
             outStream << std::format("[ deviceMemory ] ERROR\nInvalid memory type index!\n");
@@ -1486,6 +2307,29 @@ class deviceMemory {
                                .propertyFlags;
         return VK_SUCCESS;
     }
+    // 优先从deviceMemoryAllocator中子分配，对象过大或分配块失败时退回到独立分配
+    result_t Allocate(VkMemoryAllocateInfo& allocateInfo, VkDeviceSize alignment, bool forImage) {
+        if (allocateInfo.memoryTypeIndex >= graphicsBase::Base().PhysicalDeviceMemoryProperties().memoryTypeCount) {
+            outStream << std::format("[ deviceMemory ] ERROR\nInvalid memory type index!\n");
+            return VK_RESULT_MAX_ENUM;
+        }
+        VkDeviceSize size = allocateInfo.allocationSize;
+        pBlock = deviceMemoryAllocator::Get().Allocate(
+            allocateInfo.memoryTypeIndex, forImage, size, alignment, memoryOffset, blockGeneration
+        );
+        if (!pBlock) {
+            memoryOffset = 0;
+            return Allocate(allocateInfo);
+        }
+        handle = pBlock->memory;
+        allocationSize = size;
+        if (pBlock->pMappedData) { pMappedData = static_cast<uint8_t*>(pBlock->pMappedData) + memoryOffset; }
+        memoryProperties = graphicsBase::Base()
+                               .PhysicalDeviceMemoryProperties()
+                               .memoryTypes[allocateInfo.memoryTypeIndex]
+                               .propertyFlags;
+        return VK_SUCCESS;
+    }
 };
 
 // 缓冲区类,引用设备内存，指代缓冲区数据
@@ -1501,6 +2345,11 @@ class buffer {
     DefineHandleTypeOperator;
     DefineAddressFunction;
     // Const function
+    VkMemoryRequirements MemoryRequirements() const {
+        VkMemoryRequirements memoryRequirements;
+        vkGetBufferMemoryRequirements(graphicsBase::Base().Device(), handle, &memoryRequirements);
+        return memoryRequirements;
+    }
     VkMemoryAllocateInfo MemoryAllocateInfo(VkMemoryPropertyFlags desiredMemoryProperties) const {
         VkMemoryAllocateInfo memoryAllocateInfo = {
             .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
@@ -1548,8 +2397,10 @@ class buffer {
 class bufferMemory : buffer, deviceMemory {
   public:
     bufferMemory() = default;
-    bufferMemory(VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags desiredMemoryProperties) {
-        Create(createInfo, desiredMemoryProperties);
+    bufferMemory(
+        VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags desiredMemoryProperties, bool dedicated = false
+    ) {
+        Create(createInfo, desiredMemoryProperties, dedicated);
     }
     bufferMemory(bufferMemory&& other) noexcept : buffer(std::move(other)), deviceMemory(std::move(other)) {
         areBound = other.areBound;
@@ -1564,35 +2415,46 @@ class bufferMemory : buffer, deviceMemory {
     // 若areBound 为true则表示成功分配了设备内存、创建了缓冲区且成功绑定
     auto AreBound() const { return areBound; }
     using deviceMemory::AllocationSize;
+    using deviceMemory::IsPersistentlyMapped;
+    using deviceMemory::IsSubAllocated;
+    using deviceMemory::MappedData;
+    using deviceMemory::MemoryOffset;
     using deviceMemory::MemoryProperties;
     // Const function
     using deviceMemory::BufferData;
+    using deviceMemory::FlushRanges;
+    using deviceMemory::InvalidateRanges;
     using deviceMemory::MapMemory;
     using deviceMemory::RetrieveData;
     using deviceMemory::UnmapMemory;
 
     // Non-const function
+    using deviceMemory::PersistentlyMap;
     result_t CreateBuffer(VkBufferCreateInfo& createInfo) { return buffer::Create(createInfo); }
 
-    result_t AllocateMemory(VkMemoryPropertyFlags desiredMemoryProperties) {
+    // dedicated为true时独占一次vkAllocateMemory，否则从deviceMemoryAllocator的块中子分配
+    result_t AllocateMemory(VkMemoryPropertyFlags desiredMemoryProperties, bool dedicated = false) {
         VkMemoryAllocateInfo allocateInfo = MemoryAllocateInfo(desiredMemoryProperties);
         if (allocateInfo.memoryTypeIndex >= graphicsBase::Base().PhysicalDeviceMemoryProperties().memoryTypeCount) {
             return VK_RESULT_MAX_ENUM;
         }
-        return Allocate(allocateInfo);
+        if (dedicated) { return Allocate(allocateInfo); }
+        return Allocate(allocateInfo, MemoryRequirements().alignment, false);
     }
 
     result_t BindMemory() {
-        if (VkResult result = buffer::BindMemory(Memory())) { return result; }
+        if (VkResult result = buffer::BindMemory(Memory(), MemoryOffset())) { return result; }
         areBound = true;
         return VK_SUCCESS;
     }
 
     // 分配设备内存、创建缓冲区并绑定内存
-    result_t Create(VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags desiredMemoryProperties) {
+    result_t Create(
+        VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags desiredMemoryProperties, bool dedicated = false
+    ) {
         VkResult result;
-        false || (result = CreateBuffer(createInfo)) || (result = AllocateMemory(desiredMemoryProperties)) ||
-            (result = BindMemory());
+        false || (result = CreateBuffer(createInfo)) ||
+            (result = AllocateMemory(desiredMemoryProperties, dedicated)) || (result = BindMemory());
         return result;
     }
 };
@@ -1646,6 +2508,11 @@ class image {
     DefineHandleTypeOperator;
     DefineAddressFunction;
     // Const function
+    VkMemoryRequirements MemoryRequirements() const {
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(graphicsBase::Base().Device(), handle, &memoryRequirements);
+        return memoryRequirements;
+    }
     VkMemoryAllocateInfo MemoryAllocateInfo(VkMemoryPropertyFlags desiredMemoryProperties) const {
         VkMemoryAllocateInfo memoryAllocateInfo = {.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
         VkMemoryRequirements memoryRequirements;
@@ -1697,7 +2564,11 @@ class image {
 class imageMemory : image, deviceMemory {
   public:
     imageMemory() = default;
-    imageMemory(VkImageCreateInfo& createInfo, VkMemoryPropertyFlags desiredMemoryProperties) {}
+    imageMemory(
+        VkImageCreateInfo& createInfo, VkMemoryPropertyFlags desiredMemoryProperties, bool dedicated = false
+    ) {
+        Create(createInfo, desiredMemoryProperties, dedicated);
+    }
     imageMemory(imageMemory&& other) noexcept : image(std::move(other)), deviceMemory(std::move(other)) {
         areBound = other.areBound;
         other.areBound = false;
@@ -1710,27 +2581,33 @@ class imageMemory : image, deviceMemory {
     const VkDeviceMemory* AddressOfMemory() const { return deviceMemory::Address(); }
     auto AreBound() const { return areBound; }
     using deviceMemory::AllocationSize;
+    using deviceMemory::IsSubAllocated;
+    using deviceMemory::MemoryOffset;
     using deviceMemory::MemoryProperties;
     // Non-const function
     result_t CreateImage(VkImageCreateInfo& createInfo) { return image::Create(createInfo); }
 
-    result_t AllocateMemory(VkMemoryPropertyFlags desiredMemoryProperties) {
+    // dedicated为true时独占一次vkAllocateMemory，否则从deviceMemoryAllocator的块中子分配
+    result_t AllocateMemory(VkMemoryPropertyFlags desiredMemoryProperties, bool dedicated = false) {
         VkMemoryAllocateInfo allocateInfo = MemoryAllocateInfo(desiredMemoryProperties);
         if (allocateInfo.memoryTypeIndex >= graphicsBase::Base().PhysicalDeviceMemoryProperties().memoryTypeCount) {
             return VK_RESULT_MAX_ENUM;
         }
-        return Allocate(allocateInfo);
+        if (dedicated) { return Allocate(allocateInfo); }
+        return Allocate(allocateInfo, MemoryRequirements().alignment, true);
     }
 
     result_t BindMemory() {
-        if (VkResult result = image::BindMemory(Memory())) { return result; }
+        if (VkResult result = image::BindMemory(Memory(), MemoryOffset())) { return result; }
         areBound = true;
         return VK_SUCCESS;
     }
 
-    result_t Create(VkImageCreateInfo& createInfo, VkMemoryPropertyFlags desiredMemoryProperties) {
+    result_t Create(
+        VkImageCreateInfo& createInfo, VkMemoryPropertyFlags desiredMemoryProperties, bool dedicated = false
+    ) {
         VkResult result;
-        false || (result = CreateImage(createInfo)) || (result = AllocateMemory(desiredMemoryProperties)) ||
+        false || (result = CreateImage(createInfo)) || (result = AllocateMemory(desiredMemoryProperties, dedicated)) ||
             (result = BindMemory());
         return result;
     }
@@ -1806,6 +2683,7 @@ class descriptorSetLayout {
 
 class descriptorSet {
     friend class descriptorPool;
+    friend class descriptorAllocator;
     VkDescriptorSet handle = VK_NULL_HANDLE;
 
   public:
@@ -1873,6 +2751,198 @@ class descriptorSet {
     }
 };
 
+/**
+ * 批量写入描述符
+ * 收集对多个描述符集的图像、缓冲区、texel缓冲区写入，描述符信息复制到同一块连续内存中，
+ * Flush()时以一次vkUpdateDescriptorSets(...)完成所有写入，之后可复用已分配的内存继续收集
+ */
+class descriptorWriteBatch {
+    enum infoType : uint8_t { image, buffer, texelBufferView };
+    struct infoLocation {
+        size_t offset;  // 描述符信息在arena中的偏移
+        infoType type;
+    };
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<infoLocation> infoLocations;
+    std::vector<uint8_t> arena;
+
+    template <typename T>
+    void Add(
+        VkDescriptorSet dstSet, arrayRef<const T> descriptorInfos, infoType type, VkDescriptorType descriptorType,
+        uint32_t dstBinding, uint32_t dstArrayElement
+    ) {
+        // vector的内存按new的默认对齐分配，满足各描述符信息类型的对齐要求
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        size_t offset = arena.size() + alignof(T) - 1 & ~(alignof(T) - 1);
+        arena.resize(offset + sizeof(T) * descriptorInfos.Count());
+        memcpy(arena.data() + offset, descriptorInfos.Pointer(), sizeof(T) * descriptorInfos.Count());
+        writes.push_back({
+            .dstSet = dstSet,
+            .dstBinding = dstBinding,
+            .dstArrayElement = dstArrayElement,
+            .descriptorCount = static_cast<uint32_t>(descriptorInfos.Count()),
+            .descriptorType = descriptorType
+        });
+        infoLocations.emplace_back(offset, type);
+    }
+
+  public:
+    descriptorWriteBatch() = default;
+    // 预留空间，避免收集过程中反复扩容
+    descriptorWriteBatch(size_t writeCount, size_t arenaSize) {
+        writes.reserve(writeCount);
+        infoLocations.reserve(writeCount);
+        arena.reserve(arenaSize);
+    }
+    // Getter
+    size_t Count() const { return writes.size(); }
+    // Non-const function
+    void Write(
+        VkDescriptorSet dstSet, arrayRef<const VkDescriptorImageInfo> descriptorInfos, VkDescriptorType descriptorType,
+        uint32_t dstBinding = 0, uint32_t dstArrayElement = 0
+    ) {
+        Add(dstSet, descriptorInfos, image, descriptorType, dstBinding, dstArrayElement);
+    }
+    void Write(
+        VkDescriptorSet dstSet, arrayRef<const VkDescriptorBufferInfo> descriptorInfos, VkDescriptorType descriptorType,
+        uint32_t dstBinding = 0, uint32_t dstArrayElement = 0
+    ) {
+        Add(dstSet, descriptorInfos, buffer, descriptorType, dstBinding, dstArrayElement);
+    }
+    void Write(
+        VkDescriptorSet dstSet, arrayRef<const VkBufferView> descriptorInfos, VkDescriptorType descriptorType,
+        uint32_t dstBinding = 0, uint32_t dstArrayElement = 0
+    ) {
+        Add(dstSet, descriptorInfos, texelBufferView, descriptorType, dstBinding, dstArrayElement);
+    }
+    void Write(
+        VkDescriptorSet dstSet, arrayRef<const bufferView> descriptorInfos, VkDescriptorType descriptorType,
+        uint32_t dstBinding = 0, uint32_t dstArrayElement = 0
+    ) {
+        Write(
+            dstSet, {descriptorInfos[0].Address(), descriptorInfos.Count()}, descriptorType, dstBinding, dstArrayElement
+        );
+    }
+    // 写入所有收集到的描述符，arena在收集过程中可能扩容，因此到此时才将偏移转为指针
+    void Flush() {
+        if (writes.empty()) { return; }
+        for (size_t i = 0; i < writes.size(); i++) {
+            const uint8_t* pInfos = arena.data() + infoLocations[i].offset;
+            switch (infoLocations[i].type) {
+                case image:
+                    writes[i].pImageInfo = reinterpret_cast<const VkDescriptorImageInfo*>(pInfos);
+                    break;
+                case buffer:
+                    writes[i].pBufferInfo = reinterpret_cast<const VkDescriptorBufferInfo*>(pInfos);
+                    break;
+                case texelBufferView:
+                    writes[i].pTexelBufferView = reinterpret_cast<const VkBufferView*>(pInfos);
+                    break;
+            }
+        }
+        descriptorSet::Update(arrayRef<VkWriteDescriptorSet>(writes));
+        Clear();
+    }
+    // 丢弃尚未写入的描述符，保留已分配的内存
+    void Clear() {
+        writes.clear();
+        infoLocations.clear();
+        arena.clear();
+    }
+};
+
+/**
+ * 描述符更新模板（Vulkan 1.1）
+ * 模板记录描述符信息在一个C++结构体中的偏移和步长，之后每次更新只需一次调用并传入该结构体的地址，
+ * 无需逐次构建VkWriteDescriptorSet，例如
+ * struct perFrameDescriptors { VkDescriptorBufferInfo camera; VkDescriptorImageInfo textures[4]; };
+ * descriptorUpdateTemplate::Entry(&perFrameDescriptors::camera, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+ */
+class descriptorUpdateTemplate {
+    VkDescriptorUpdateTemplate handle = VK_NULL_HANDLE;
+
+  public:
+    descriptorUpdateTemplate() = default;
+    explicit descriptorUpdateTemplate(VkDescriptorUpdateTemplateCreateInfo& createInfo) { Create(createInfo); }
+    descriptorUpdateTemplate(VkDescriptorSetLayout setLayout, arrayRef<const VkDescriptorUpdateTemplateEntry> entries) {
+        Create(setLayout, entries);
+    }
+    descriptorUpdateTemplate(descriptorUpdateTemplate&& other) noexcept { MoveHandle; }
+    ~descriptorUpdateTemplate() { DestroyHandleBy(vkDestroyDescriptorUpdateTemplate); }
+    // Getter
+    DefineHandleTypeOperator;
+    DefineAddressFunction;
+    // Const function
+    // pData指向创建模板时所描述的结构体
+    void Update(VkDescriptorSet dstSet, const void* pData) const {
+        vkUpdateDescriptorSetWithTemplate(graphicsBase::Base().Device(), dstSet, handle, pData);
+    }
+    template <typename T>
+        requires(!std::is_pointer_v<T>)
+    void Update(VkDescriptorSet dstSet, const T& data) const {
+        Update(dstSet, static_cast<const void*>(&data));
+    }
+    // Non-const function
+    result_t Create(VkDescriptorUpdateTemplateCreateInfo& createInfo) {
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        uint32_t version = std::min(
+            graphicsBase::Base().ApiVersion(), graphicsBase::Base().PhysicalDeviceProperties().apiVersion
+        );
+        if (version < VK_API_VERSION_1_1) {
+            outStream << std::format(
+                "[ descriptorUpdateTemplate ] ERROR\nDescriptor update templates need Vulkan 1.1, call "
+                "graphicsBase::UseLatestApiVersion() before creating the instance!\n"
+            );
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        VkResult result =
+            vkCreateDescriptorUpdateTemplate(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result) {
+            outStream << std::format(
+                "[ descriptorUpdateTemplate ] ERROR\nFailed to create a descriptor update template!\nError code: {}\n",
+                int32_t(result)
+            );
+        }
+        return result;
+    }
+    result_t Create(VkDescriptorSetLayout setLayout, arrayRef<const VkDescriptorUpdateTemplateEntry> entries) {
+        VkDescriptorUpdateTemplateCreateInfo createInfo = {
+            .descriptorUpdateEntryCount = static_cast<uint32_t>(entries.Count()),
+            .pDescriptorUpdateEntries = entries.Pointer(),
+            .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+            .descriptorSetLayout = setLayout
+        };
+        return Create(createInfo);
+    }
+    // Static function
+    /**
+     * 由结构体T的成员生成模板条目，成员可以是单个描述符信息(VkDescriptorImageInfo、VkDescriptorBufferInfo、VkBufferView)
+     * 或其数组，数组的长度即为descriptorCount
+     */
+    template <typename T, typename M>
+        requires std::is_default_constructible_v<T>
+    static VkDescriptorUpdateTemplateEntry Entry(
+        M T::*member, uint32_t dstBinding, VkDescriptorType descriptorType, uint32_t dstArrayElement = 0
+    ) {
+        using element_t = std::remove_all_extents_t<M>;
+        static_assert(
+            false || std::same_as<element_t, VkDescriptorImageInfo> ||
+                std::same_as<element_t, VkDescriptorBufferInfo> || std::same_as<element_t, VkBufferView>,
+            "The member must be descriptor infos or an array of them."
+        );
+        T object{};
+        auto pObject = reinterpret_cast<const uint8_t*>(&object);
+        return {
+            .dstBinding = dstBinding,
+            .dstArrayElement = dstArrayElement,
+            .descriptorCount = static_cast<uint32_t>(sizeof(M) / sizeof(element_t)),
+            .descriptorType = descriptorType,
+            .offset = static_cast<size_t>(reinterpret_cast<const uint8_t*>(&(object.*member)) - pObject),
+            .stride = sizeof(element_t)
+        };
+    }
+};
+
 class descriptorPool {
     VkDescriptorPool handle = VK_NULL_HANDLE;
 
@@ -1938,6 +3008,11 @@ class descriptorPool {
         return result;  // Though vkFreeDescriptorSets(...) can only return VK_SUCCESS
     }
     result_t FreeSets(arrayRef<descriptorSet> sets) const { return FreeSets({&sets[0].handle, sets.Count()}); }
+    // 回收从池中分配的所有描述符集，调用前需确保它们不再被任何执行中的命令使用
+    result_t Reset() const {
+        VkResult result = vkResetDescriptorPool(graphicsBase::Base().Device(), handle, 0);
+        return result;  // Though vkResetDescriptorPool(...) can only return VK_SUCCESS
+    }
     // Non-const function
     result_t Create(VkDescriptorPoolCreateInfo& createInfo) {
         createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -0,0 +1,473 @@
+#pragma once
+
+#include "VKBase+.h"
+
+namespace vulkan {
+
+/**
+ * 帧图
+ * 各步骤（pass）声明对缓冲区和图像的使用（管线阶段、访问类型、图像布局），Compile()时：
+ * 1.剔除结果最终不被使用的步骤：从导入的资源（图外可见的结果）和带副作用的步骤出发反向推导
+ * 2.按声明顺序排列其余步骤：步骤只能读取在它之前声明的步骤写入的内容，声明顺序即为合法的执行顺序
+ * 3.为每个步骤算出所需的最少屏障，以一次vkCmdPipelineBarrier(...)录制
+ * 4.让生存期不重叠的临时图像共用同一块设备内存
+ * 临时图像被飞行中的各帧共用，每帧中对临时图像的首次使用会等待前一帧中对它及与之共用内存的图像的读写完成
+ * 在渲染通道中使用的图像，其声明的布局应与渲染通道中该附件的initialLayout和finalLayout一致
+ * 须在销毁逻辑设备前销毁
+ */
+class frameGraph {
+  public:
+    using resource = uint32_t;
+    using executeFunction = std::function<void(VkCommandBuffer commandBuffer)>;
+    static constexpr VkAccessFlags writeAccesses = resourceStateTracker::writeAccesses;
+
+  private:
+    struct resourceInfo {
+        bool isImage = false;
+        bool imported = false;
+        VkImage image = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImageSubresourceRange subresourceRange = {};
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = VK_WHOLE_SIZE;
+        // 导入的资源在帧开始时的状态，以及帧结束时图像应处于的布局
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags initialStages = 0;
+        VkAccessFlags initialAccesses = 0;
+        // 临时图像
+        VkImageCreateInfo createInfo = {};
+        VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
+        uint32_t transientIndex = UINT32_MAX;  // 在transientImages中的索引，未被使用时为UINT32_MAX
+        uint32_t memorySlot = UINT32_MAX;
+    };
+    struct use {
+        resource target;
+        VkPipelineStageFlags stages;
+        VkAccessFlags accesses;
+        VkImageLayout layout;
+    };
+    struct pass {
+        std::string name;
+        executeFunction execute;
+        std::vector<use> uses;
+        bool sideEffect = false;
+        bool culled = false;
+    };
+    struct barrierRecord {
+        resource target;
+        VkAccessFlags srcAccesses;
+        VkAccessFlags dstAccesses;
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+    };
+    struct barrierBatch {
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        std::vector<barrierRecord> barriers;
+    };
+    // 编译时模拟执行过程所用的资源状态
+    struct resourceState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags writeStages = 0;  // 最近一次写入（含布局转换）的阶段
+        VkAccessFlags writeAccesses = 0;
+        VkPipelineStageFlags readStages = 0;  // 最近一次写入后，已与其同步的读取的阶段
+        VkAccessFlags readAccesses = 0;
+        bool used = false;
+    };
+    struct memorySlotState {
+        VkPipelineStageFlags stages = 0;
+        VkAccessFlags writeAccesses = 0;
+    };
+
+    std::vector<resourceInfo> resources;
+    std::vector<pass> passes;
+    std::vector<barrierBatch> barrierBatches;  // 与passes按索引对应，最后多一个将导入图像转换到finalLayout的批次
+    std::vector<deviceMemory> memorySlots;
+    std::vector<image> transientImages;
+    std::vector<imageView> transientImageViews;
+    bool compiled = false;
+
+    void CullPasses() {
+        // needed[i]表示资源i当前的内容在之后会被读取，或在图外可见
+        std::vector<bool> needed(resources.size());
+        for (size_t i = 0; i < resources.size(); i++) { needed[i] = resources[i].imported; }
+        for (auto pass = passes.rbegin(); pass != passes.rend(); pass++) {
+            pass->culled = !pass->sideEffect && std::ranges::none_of(pass->uses, [&](const use& use) {
+                return use.accesses & writeAccesses && needed[use.target];
+            });
+            if (pass->culled) { continue; }
+            // 只写不读的资源，其之前的内容不再被需要
+            for (auto& use : pass->uses) {
+                if (use.accesses & writeAccesses && !(use.accesses & ~writeAccesses)) { needed[use.target] = false; }
+            }
+            for (auto& use : pass->uses) {
+                if (use.accesses & ~writeAccesses) { needed[use.target] = true; }
+            }
+        }
+    }
+    // 创建被未剔除的步骤使用的临时图像，生存期不重叠且内存类型兼容者共用一块内存
+    result_t CreateTransientImages() {
+        struct lifetime {
+            resource target;
+            size_t first = SIZE_MAX;
+            size_t last = 0;
+            VkMemoryRequirements memoryRequirements;
+        };
+        std::vector<lifetime> lifetimes;
+        std::vector<uint32_t> lifetimeIndices(resources.size(), UINT32_MAX);
+        for (size_t i = 0; i < passes.size(); i++) {
+            if (passes[i].culled) { continue; }
+            for (auto& use : passes[i].uses) {
+                resourceInfo& info = resources[use.target];
+                if (info.imported || !info.isImage) { continue; }
+                uint32_t& index = lifetimeIndices[use.target];
+                if (index == UINT32_MAX) {
+                    index = static_cast<uint32_t>(lifetimes.size());
+                    lifetimes.push_back({use.target});
+                }
+                lifetimes[index].first = std::min(lifetimes[index].first, i);
+                lifetimes[index].last = std::max(lifetimes[index].last, i);
+            }
+        }
+        for (auto& i : lifetimes) {
+            resourceInfo& info = resources[i.target];
+            info.transientIndex = static_cast<uint32_t>(transientImages.size());
+            if (VkResult result = transientImages.emplace_back().Create(info.createInfo)) { return result; }
+            info.image = transientImages.back();
+            i.memoryRequirements = transientImages.back().MemoryRequirements();
+        }
+        // 由大到小依次放入第一个可容纳的槽
+        struct slot {
+            std::vector<const lifetime*> occupants;
+            uint32_t memoryTypeBits = ~0u;
+            VkDeviceSize size = 0;
+        };
+        std::vector<slot> slots;
+        std::vector<const lifetime*> sortedLifetimes;
+        for (auto& i : lifetimes) { sortedLifetimes.push_back(&i); }
+        std::ranges::sort(sortedLifetimes, std::ranges::greater{}, [](const lifetime* p) {
+            return p->memoryRequirements.size;
+        });
+        for (const lifetime* pLifetime : sortedLifetimes) {
+            auto Fits = [&](const slot& slot) {
+                return slot.memoryTypeBits & pLifetime->memoryRequirements.memoryTypeBits &&
+                       std::ranges::none_of(slot.occupants, [&](const lifetime* pOccupant) {
+                           return pOccupant->first <= pLifetime->last && pLifetime->first <= pOccupant->last;
+                       });
+            };
+            auto iterator = std::ranges::find_if(slots, Fits);
+            if (iterator == slots.end()) { iterator = slots.emplace(slots.end()); }
+            iterator->occupants.push_back(pLifetime);
+            iterator->memoryTypeBits &= pLifetime->memoryRequirements.memoryTypeBits;
+            iterator->size = std::max(iterator->size, pLifetime->memoryRequirements.size);
+            resources[pLifetime->target].memorySlot = static_cast<uint32_t>(iterator - slots.begin());
+        }
+        auto& memoryProperties = graphicsBase::Base().PhysicalDeviceMemoryProperties();
+        for (auto& slot : slots) {
+            VkMemoryAllocateInfo allocateInfo = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .allocationSize = slot.size,
+                .memoryTypeIndex = UINT32_MAX
+            };
+            for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+                if (slot.memoryTypeBits & 1 << i &&
+                    memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
+                    allocateInfo.memoryTypeIndex = i;
+                    break;
+                }
+            }
+            // 每个槽独立分配，图像均绑定到其开头
+            if (VkResult result = memorySlots.emplace_back().Allocate(allocateInfo)) { return result; }
+            for (const lifetime* pOccupant : slot.occupants) {
+                VkResult result = transientImages[resources[pOccupant->target].transientIndex].BindMemory(
+                    memorySlots.back()
+                );
+                if (result) { return result; }
+            }
+        }
+        for (auto& i : lifetimes) {
+            resourceInfo& info = resources[i.target];
+            VkResult result = transientImageViews.emplace_back().Create(
+                info.image, info.viewType, info.createInfo.format, info.subresourceRange
+            );
+            if (result) { return result; }
+        }
+        return VK_SUCCESS;
+    }
+    // 将从state到use所需的屏障加入batch，并更新state
+    static void Transition(
+        resourceState& state, const use& use, bool isImage, barrierBatch& batch, memorySlotState* pSlotState
+    ) {
+        bool firstUse = !state.used;
+        bool writes = use.accesses & writeAccesses;
+        bool changesLayout = isImage && state.layout != use.layout;
+        barrierRecord barrier = {use.target, 0, use.accesses, state.layout, use.layout};
+        VkPipelineStageFlags srcStages = 0;
+        bool needed = changesLayout;
+        if (writes || changesLayout) {
+            // 写入和布局转换须等待之前所有的读写完成
+            srcStages = state.writeStages | state.readStages;
+            barrier.srcAccesses = state.writeAccesses;
+            needed |= bool(srcStages);
+            state = {
+                .layout = isImage ? use.layout : state.layout,
+                .writeStages = use.stages,
+                .writeAccesses = use.accesses & writeAccesses,
+                // 布局转换的结果对本次使用可见
+                .readStages = writes ? 0 : use.stages,
+                .readAccesses = writes ? 0 : use.accesses,
+                .used = true
+            };
+        } else {
+            // 读后读：仅当本次读取的阶段或访问类型尚未与最近一次写入同步时需要屏障
+            if (state.writeStages &&
+                (use.stages & ~state.readStages || use.accesses & ~state.readAccesses)) {
+                srcStages = state.writeStages;
+                barrier.srcAccesses = state.writeAccesses;
+                needed = true;
+            }
+            state.readStages |= use.stages;
+            state.readAccesses |= use.accesses;
+        }
+        // 混叠的图像首次使用时，须等待先前占用同一内存的图像的所有读写完成
+        if (pSlotState && firstUse) {
+            srcStages |= pSlotState->stages;
+            barrier.srcAccesses |= pSlotState->writeAccesses;
+            needed |= bool(pSlotState->stages);
+            *pSlotState = {};
+        }
+        if (pSlotState) {
+            pSlotState->stages |= use.stages;
+            pSlotState->writeAccesses |= use.accesses & writeAccesses;
+        }
+        state.used = true;
+        if (!needed) { return; }
+        batch.srcStages |= srcStages;
+        batch.dstStages |= use.stages;
+        batch.barriers.push_back(barrier);
+    }
+    // 按声明顺序模拟执行未被剔除的步骤，将所需的屏障记录到barrierBatches，states和slotStates由帧开始时的状态变为帧结束时的状态
+    void SimulatePasses(std::vector<resourceState>& states, std::vector<memorySlotState>& slotStates) {
+        barrierBatches.assign(passes.size() + 1, {});
+        for (size_t i = 0; i < passes.size(); i++) {
+            if (passes[i].culled) { continue; }
+            for (auto& use : passes[i].uses) {
+                const resourceInfo& info = resources[use.target];
+                memorySlotState* pSlotState = info.memorySlot == UINT32_MAX ? nullptr : &slotStates[info.memorySlot];
+                Transition(states[use.target], use, info.isImage, barrierBatches[i], pSlotState);
+            }
+        }
+    }
+    void CalculateBarriers() {
+        std::vector<resourceState> states(resources.size());
+        std::vector<memorySlotState> slotStates(memorySlots.size());
+        // 临时图像及其内存被飞行中的各帧共用，先模拟一帧得到它们在帧结束时的读写，作为帧开始时的状态，
+        // 使每帧中的首次使用等待前一帧中对同一图像或同一内存的读写完成；内容不需保留，布局仍从UNDEFINED开始
+        SimulatePasses(states, slotStates);
+        for (size_t i = 0; i < resources.size(); i++) {
+            if (resources[i].imported) {
+                states[i] = {
+                    .layout = resources[i].initialLayout,
+                    .writeStages = resources[i].initialStages,
+                    .writeAccesses = resources[i].initialAccesses & writeAccesses
+                };
+            } else {
+                states[i] = {
+                    .writeStages = states[i].writeStages,
+                    .writeAccesses = states[i].writeAccesses,
+                    .readStages = states[i].readStages,
+                    .readAccesses = states[i].readAccesses
+                };
+            }
+        }
+        SimulatePasses(states, slotStates);
+        // 帧结束时将导入的图像转换到指定布局，例如交换链图像的VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+        for (size_t i = 0; i < resources.size(); i++) {
+            const resourceInfo& info = resources[i];
+            if (!info.imported || !info.isImage || states[i].layout == info.finalLayout) { continue; }
+            use use = {static_cast<resource>(i), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, info.finalLayout};
+            Transition(states[i], use, true, barrierBatches.back(), nullptr);
+        }
+    }
+    void CmdBarriers(VkCommandBuffer commandBuffer, const barrierBatch& batch) const {
+        pipelineBarrierBatch pipelineBarrierBatch;
+        for (auto& i : batch.barriers) {
+            const resourceInfo& info = resources[i.target];
+            if (info.isImage) {
+                pipelineBarrierBatch.Add(batch.srcStages, batch.dstStages, VkImageMemoryBarrier{
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = i.srcAccesses,
+                    .dstAccessMask = i.dstAccesses,
+                    .oldLayout = i.oldLayout,
+                    .newLayout = i.newLayout,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = info.image,
+                    .subresourceRange = info.subresourceRange
+                });
+            } else {
+                pipelineBarrierBatch.Add(batch.srcStages, batch.dstStages, VkBufferMemoryBarrier{
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                    .srcAccessMask = i.srcAccesses,
+                    .dstAccessMask = i.dstAccesses,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .buffer = info.buffer,
+                    .offset = info.offset,
+                    .size = info.size
+                });
+            }
+        }
+        pipelineBarrierBatch.Flush(commandBuffer);
+    }
+
+  public:
+    // 以链式调用声明步骤对资源的使用，访问类型中含写入时视作写入该资源，对缓冲区而言layout被忽略
+    class passBuilder {
+        frameGraph& graph;
+        uint32_t index;
+
+      public:
+        passBuilder(frameGraph& graph, uint32_t index) : graph(graph), index(index) {}
+        // Getter
+        uint32_t Index() const { return index; }
+        // Non-const function
+        passBuilder& Use(
+            resource resource, VkPipelineStageFlags stages, VkAccessFlags accesses,
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED
+        ) {
+            graph.passes[index].uses.push_back({resource, stages, accesses, layout});
+            graph.compiled = false;
+            return *this;
+        }
+        // 有图外可见的副作用（如写入不由帧图管理的资源）的步骤不会被剔除
+        passBuilder& SideEffect() {
+            graph.passes[index].sideEffect = true;
+            return *this;
+        }
+    };
+
+    frameGraph() = default;
+    frameGraph(frameGraph&&) = default;
+    // Getter
+    bool IsCompiled() const { return compiled; }
+    bool IsCulled(uint32_t pass) const { return passes[pass].culled; }
+    const std::string& PassName(uint32_t pass) const { return passes[pass].name; }
+    size_t PassCount() const { return passes.size(); }
+    // 临时图像实际占用的设备内存块数
+    size_t MemorySlotCount() const { return memorySlots.size(); }
+    VkImage Image(resource resource) const { return resources[resource].image; }
+    // 临时图像的image view，图像未被使用时为VK_NULL_HANDLE
+    VkImageView ImageView(resource resource) const {
+        uint32_t index = resources[resource].transientIndex;
+        return index == UINT32_MAX ? VK_NULL_HANDLE : static_cast<VkImageView>(transientImageViews[index]);
+    }
+    // Const function
+    // 按顺序录制未被剔除的步骤及各步骤前的屏障
+    void Execute(VkCommandBuffer commandBuffer) const {
+        if (!compiled) {
+            outStream << std::format("[ frameGraph ] ERROR\nThe frame graph has not been compiled!\n");
+            return;
+        }
+        for (size_t i = 0; i < passes.size(); i++) {
+            if (passes[i].culled) { continue; }
+            CmdBarriers(commandBuffer, barrierBatches[i]);
+            if (passes[i].execute) { passes[i].execute(commandBuffer); }
+        }
+        CmdBarriers(commandBuffer, barrierBatches.back());
+    }
+    // Non-const function
+    /**
+     * 导入由外部管理的图像，导入的资源在图外可见，写入它的步骤不会被剔除
+     * initialStages和initialAccesses为帧开始前最后一次写入所在的阶段和访问类型，已由信号量等方式同步时可为0
+     * 对交换链图像，initialStages应为等待获取图像的信号量时的阶段，以使布局转换在获取图像后进行
+     */
+    resource ImportImage(
+        VkImage image, const VkImageSubresourceRange& subresourceRange, VkImageLayout initialLayout,
+        VkImageLayout finalLayout, VkPipelineStageFlags initialStages = 0, VkAccessFlags initialAccesses = 0
+    ) {
+        compiled = false;
+        resources.push_back({
+            .isImage = true,
+            .imported = true,
+            .image = image,
+            .subresourceRange = subresourceRange,
+            .initialLayout = initialLayout,
+            .finalLayout = finalLayout,
+            .initialStages = initialStages,
+            .initialAccesses = initialAccesses
+        });
+        return static_cast<resource>(resources.size() - 1);
+    }
+    resource ImportBuffer(
+        VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE,
+        VkPipelineStageFlags initialStages = 0, VkAccessFlags initialAccesses = 0
+    ) {
+        compiled = false;
+        resources.push_back({
+            .imported = true,
+            .buffer = buffer,
+            .offset = offset,
+            .size = size,
+            .initialStages = initialStages,
+            .initialAccesses = initialAccesses
+        });
+        return static_cast<resource>(resources.size() - 1);
+    }
+    // 声明临时图像，由Compile()创建，其内容在帧之间不保留
+    resource CreateImage(
+        const VkImageCreateInfo& createInfo, VkImageAspectFlags aspectMask,
+        VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D
+    ) {
+        compiled = false;
+        resources.push_back({
+            .isImage = true,
+            .subresourceRange = {aspectMask, 0, createInfo.mipLevels, 0, createInfo.arrayLayers},
+            .createInfo = createInfo,
+            .viewType = viewType
+        });
+        resources.back().createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        return static_cast<resource>(resources.size() - 1);
+    }
+    // 更换导入资源的handle（如每帧的交换链图像），无需重新编译
+    void SetImage(resource resource, VkImage image) { resources[resource].image = image; }
+    void SetBuffer(resource resource, VkBuffer buffer) { resources[resource].buffer = buffer; }
+    passBuilder AddPass(std::string name, executeFunction execute) {
+        compiled = false;
+        passes.push_back({std::move(name), std::move(execute)});
+        return {*this, static_cast<uint32_t>(passes.size() - 1)};
+    }
+    // 调用前需确保先前编译所创建的临时图像不再被任何执行中的命令使用
+    result_t Compile() {
+        compiled = false;
+        transientImageViews.clear();
+        transientImages.clear();
+        memorySlots.clear();
+        for (auto& i : resources) {
+            if (i.imported) { continue; }
+            i.image = VK_NULL_HANDLE;
+            i.transientIndex = i.memorySlot = UINT32_MAX;
+        }
+        CullPasses();
+        if (VkResult result = CreateTransientImages()) {
+            outStream << std::format(
+                "[ frameGraph ] ERROR\nFailed to create transient images!\nError code: {}\n", int32_t(result)
+            );
+            return result;
+        }
+        CalculateBarriers();
+        compiled = true;
+        return VK_SUCCESS;
+    }
+    void Clear() {
+        compiled = false;
+        passes.clear();
+        barrierBatches.clear();
+        transientImageViews.clear();
+        transientImages.clear();
+        memorySlots.clear();
+        resources.clear();
+    }
+};
+}  // namespace vulkan
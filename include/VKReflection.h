@@ -0,0 +1,426 @@
+#pragma once
+
+#include "VKBase+.h"
+
+namespace vulkan {
+
+/**
+ * 轻量的SPIR-V反射
+ * 只解析生成布局所需的指令：入口点、类型、常量、变量和修饰，得到描述符绑定、push constant范围和顶点输入
+ * 不依赖SPIRV-Reflect等外部库，所用的操作码和枚举值取自SPIR-V规范，假定输入的SPIR-V已通过验证
+ * 以特化常量为长度的数组按特化常量的默认值计算，特化为其他值时须自行调整相应的descriptorCount或大小
+ */
+class shaderReflection {
+  public:
+    struct descriptorBinding {
+        uint32_t set;
+        VkDescriptorSetLayoutBinding binding;
+    };
+
+  private:
+    VkShaderStageFlagBits stage = VkShaderStageFlagBits(0);
+    std::vector<descriptorBinding> descriptorBindings;
+    std::vector<VkPushConstantRange> pushConstantRanges;
+    std::vector<VkVertexInputAttributeDescription> vertexInputs;
+
+    struct spv {
+        static constexpr uint32_t magicNumber = 0x07230203;
+        enum op : uint32_t {
+            opEntryPoint = 15,
+            opTypeInt = 21,
+            opTypeFloat = 22,
+            opTypeVector = 23,
+            opTypeMatrix = 24,
+            opTypeImage = 25,
+            opTypeSampler = 26,
+            opTypeSampledImage = 27,
+            opTypeArray = 28,
+            opTypeRuntimeArray = 29,
+            opTypeStruct = 30,
+            opTypePointer = 32,
+            opConstant = 43,
+            opSpecConstant = 50,
+            opVariable = 59,
+            opDecorate = 71,
+            opMemberDecorate = 72,
+            opTypeAccelerationStructure = 5341
+        };
+        enum decoration : uint32_t {
+            decorationBlock = 2,
+            decorationBufferBlock = 3,
+            decorationArrayStride = 6,
+            decorationMatrixStride = 7,
+            decorationBuiltIn = 11,
+            decorationLocation = 30,
+            decorationBinding = 33,
+            decorationDescriptorSet = 34,
+            decorationOffset = 35
+        };
+        enum storageClass : uint32_t {
+            storageClassUniformConstant = 0,
+            storageClassInput = 1,
+            storageClassUniform = 2,
+            storageClassPushConstant = 9,
+            storageClassStorageBuffer = 12
+        };
+        enum dim : uint32_t {
+            dimBuffer = 5,
+            dimSubpassData = 6
+        };
+    };
+    // 解析过程中收集的、以result id为索引的信息
+    struct id {
+        uint32_t opcode = 0;
+        std::vector<uint32_t> operands;  // 类型指令中result id之后的操作数，常量为其值，变量为[类型, 存储类别]
+        uint32_t set = 0;
+        uint32_t binding = UINT32_MAX;
+        uint32_t location = UINT32_MAX;
+        uint32_t arrayStride = 0;
+        bool block = false;
+        bool bufferBlock = false;
+        bool builtIn = false;
+        std::vector<uint32_t> memberOffsets;
+        std::vector<uint32_t> memberMatrixStrides;
+    };
+    std::vector<id> ids;
+
+    static constexpr VkShaderStageFlagBits ExecutionModelToStage(uint32_t executionModel) {
+        constexpr VkShaderStageFlagBits stages[] = {
+            VK_SHADER_STAGE_VERTEX_BIT,
+            VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+            VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+            VK_SHADER_STAGE_GEOMETRY_BIT,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            VK_SHADER_STAGE_COMPUTE_BIT
+        };
+        return executionModel < std::size(stages) ? stages[executionModel] : VkShaderStageFlagBits(0);
+    }
+    static void SetMember(std::vector<uint32_t>& members, uint32_t index, uint32_t value) {
+        if (members.size() <= index) { members.resize(index + 1); }
+        members[index] = value;
+    }
+    uint32_t ArrayLength(const id& array) const { return ids[array.operands[1]].operands[0]; }
+    // 剥去描述符类型外层的数组，返回元素类型，数组的长度累乘到count，运行时数组不计入
+    const id& UnwrapArray(const id& type, uint32_t& count) const {
+        if (type.opcode == spv::opTypeArray) {
+            count *= ArrayLength(type);
+            return UnwrapArray(ids[type.operands[0]], count);
+        }
+        if (type.opcode == spv::opTypeRuntimeArray) { return UnwrapArray(ids[type.operands[0]], count); }
+        return type;
+    }
+    // 按显式布局计算类型的大小，matrixStride来自结构体成员的修饰
+    uint32_t SizeOf(const id& type, uint32_t matrixStride = 0) const {
+        switch (type.opcode) {
+            case spv::opTypeInt:
+            case spv::opTypeFloat:
+                return type.operands[0] / 8;
+            case spv::opTypeVector:
+                return type.operands[1] * SizeOf(ids[type.operands[0]]);
+            case spv::opTypeMatrix:
+                return type.operands[1] * (matrixStride ? matrixStride : SizeOf(ids[type.operands[0]]));
+            case spv::opTypeArray:
+                return ArrayLength(type) *
+                       (type.arrayStride ? type.arrayStride : SizeOf(ids[type.operands[0]], matrixStride));
+            case spv::opTypeStruct: {
+                uint32_t size = 0;
+                for (size_t i = 0; i < type.operands.size(); i++) {
+                    uint32_t offset = i < type.memberOffsets.size() ? type.memberOffsets[i] : 0;
+                    uint32_t stride = i < type.memberMatrixStrides.size() ? type.memberMatrixStrides[i] : 0;
+                    size = std::max(size, offset + SizeOf(ids[type.operands[i]], stride));
+                }
+                return size;
+            }
+        }
+        return 0;
+    }
+    VkDescriptorType DescriptorType(const id& type, uint32_t storageClass) const {
+        switch (type.opcode) {
+            case spv::opTypeSampler:
+                return VK_DESCRIPTOR_TYPE_SAMPLER;
+            case spv::opTypeSampledImage:
+                return ids[type.operands[0]].operands[1] == spv::dimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+                                                                           : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            case spv::opTypeImage: {
+                // 操作数依次为：采样类型、维度、深度、数组、多重采样、采样(1为采样，2为存储)
+                bool storage = type.operands[5] == 2;
+                if (type.operands[1] == spv::dimSubpassData) { return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT; }
+                if (type.operands[1] == spv::dimBuffer) {
+                    return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                }
+                return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+            case spv::opTypeStruct:
+                if (storageClass == spv::storageClassStorageBuffer || type.bufferBlock) {
+                    return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                }
+                return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            case spv::opTypeAccelerationStructure:
+                return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+        }
+        return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    }
+    // 仅处理32位标量和向量，其余(矩阵、64位类型等)的格式为VK_FORMAT_UNDEFINED，由使用者自行填写
+    VkFormat VertexInputFormat(const id& type) const {
+        static constexpr VkFormat formats[3][4] = {
+            {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT},
+            {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT},
+            {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT}
+        };
+        uint32_t componentCount = 1;
+        const id* pComponent = &type;
+        if (type.opcode == spv::opTypeVector) {
+            componentCount = type.operands[1];
+            pComponent = &ids[type.operands[0]];
+        }
+        if (componentCount > 4 || pComponent->operands.empty() || pComponent->operands[0] != 32) {
+            return VK_FORMAT_UNDEFINED;
+        }
+        if (pComponent->opcode == spv::opTypeFloat) { return formats[0][componentCount - 1]; }
+        if (pComponent->opcode == spv::opTypeInt) {
+            // 整型的第2个操作数为符号性
+            return formats[pComponent->operands[1] ? 1 : 2][componentCount - 1];
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+    // 第一遍：记录入口点、类型、常量、变量和修饰
+    bool Parse(size_t codeSize, const uint32_t* pCode) {
+        if (codeSize < 20 || codeSize % 4 || pCode[0] != spv::magicNumber) { return false; }
+        size_t wordCount = codeSize / 4;
+        ids.assign(pCode[3], {});  // 第3个字为id的上界
+        for (size_t i = 5; i < wordCount;) {
+            uint32_t opcode = pCode[i] & 0xffff;
+            uint32_t instructionWordCount = pCode[i] >> 16;
+            if (!instructionWordCount || i + instructionWordCount > wordCount) { return false; }
+            const uint32_t* pOperands = pCode + i + 1;
+            uint32_t operandCount = instructionWordCount - 1;
+            i += instructionWordCount;
+            switch (opcode) {
+                case spv::opEntryPoint:
+                    // 只取第一个入口点
+                    if (!stage && operandCount) { stage = ExecutionModelToStage(pOperands[0]); }
+                    continue;
+                case spv::opConstant:
+                case spv::opSpecConstant:
+                    // 操作数依次为：结果类型、结果id、值(只保留低32位)，特化常量取其默认值
+                    if (operandCount < 3 || pOperands[1] >= ids.size()) { return false; }
+                    ids[pOperands[1]].opcode = opcode;
+                    ids[pOperands[1]].operands.assign(1, pOperands[2]);
+                    continue;
+                case spv::opVariable:
+                    // 操作数依次为：结果类型、结果id、存储类别
+                    if (operandCount < 3 || pOperands[1] >= ids.size()) { return false; }
+                    ids[pOperands[1]].opcode = opcode;
+                    ids[pOperands[1]].operands.assign({pOperands[0], pOperands[2]});
+                    continue;
+                case spv::opDecorate: {
+                    if (operandCount < 2 || pOperands[0] >= ids.size()) { return false; }
+                    id& target = ids[pOperands[0]];
+                    uint32_t value = operandCount > 2 ? pOperands[2] : 0;
+                    switch (pOperands[1]) {
+                        case spv::decorationBlock: target.block = true; break;
+                        case spv::decorationBufferBlock: target.bufferBlock = true; break;
+                        case spv::decorationArrayStride: target.arrayStride = value; break;
+                        case spv::decorationBuiltIn: target.builtIn = true; break;
+                        case spv::decorationLocation: target.location = value; break;
+                        case spv::decorationBinding: target.binding = value; break;
+                        case spv::decorationDescriptorSet: target.set = value; break;
+                    }
+                    continue;
+                }
+                case spv::opMemberDecorate: {
+                    if (operandCount < 4 || pOperands[0] >= ids.size()) { return false; }
+                    id& target = ids[pOperands[0]];
+                    if (pOperands[2] == spv::decorationOffset) {
+                        SetMember(target.memberOffsets, pOperands[1], pOperands[3]);
+                    }
+                    if (pOperands[2] == spv::decorationMatrixStride) {
+                        SetMember(target.memberMatrixStrides, pOperands[1], pOperands[3]);
+                    }
+                    continue;
+                }
+                case spv::opTypeArray:
+                    // 操作数依次为：结果id、元素类型、长度；长度须为常量或特化常量，由OpSpecConstantOp等算得的长度无法确定
+                    if (operandCount < 3 || pOperands[2] >= ids.size()) { return false; }
+                    if (uint32_t lengthOpcode = ids[pOperands[2]].opcode;
+                        lengthOpcode != spv::opConstant && lengthOpcode != spv::opSpecConstant) {
+                        outStream << std::format(
+                            "[ shaderReflection ] ERROR\nThe length of an array must be a constant or a specialization "
+                            "constant!\n"
+                        );
+                        return false;
+                    }
+                    [[fallthrough]];
+                case spv::opTypeInt:
+                case spv::opTypeFloat:
+                case spv::opTypeVector:
+                case spv::opTypeMatrix:
+                case spv::opTypeImage:
+                case spv::opTypeSampler:
+                case spv::opTypeSampledImage:
+                case spv::opTypeRuntimeArray:
+                case spv::opTypeStruct:
+                case spv::opTypePointer:
+                case spv::opTypeAccelerationStructure:
+                    if (!operandCount || pOperands[0] >= ids.size()) { return false; }
+                    ids[pOperands[0]].opcode = opcode;
+                    ids[pOperands[0]].operands.assign(pOperands + 1, pOperands + operandCount);
+                    continue;
+            }
+        }
+        return stage;
+    }
+    // 第二遍：由变量得到描述符绑定、push constant范围和顶点输入
+    void CollectVariables() {
+        for (auto& variable : ids) {
+            if (variable.opcode != spv::opVariable) { continue; }
+            const id& pointer = ids[variable.operands[0]];
+            uint32_t storageClass = variable.operands[1];
+            const id& type = ids[pointer.operands[1]];  // 指针类型的操作数依次为：存储类别、被指向的类型
+            switch (storageClass) {
+                case spv::storageClassUniformConstant:
+                case spv::storageClassUniform:
+                case spv::storageClassStorageBuffer: {
+                    if (variable.binding == UINT32_MAX) { continue; }
+                    uint32_t count = 1;
+                    const id& elementType = UnwrapArray(type, count);
+                    descriptorBindings.push_back({
+                        variable.set,
+                        {.binding = variable.binding,
+                         .descriptorType = DescriptorType(elementType, storageClass),
+                         .descriptorCount = count,
+                         .stageFlags = VkShaderStageFlags(stage)}
+                    });
+                    break;
+                }
+                case spv::storageClassPushConstant: {
+                    uint32_t offset = type.memberOffsets.empty() ? 0 : std::ranges::min(type.memberOffsets);
+                    pushConstantRanges.emplace_back(VkShaderStageFlags(stage), offset, SizeOf(type) - offset);
+                    break;
+                }
+                case spv::storageClassInput:
+                    if (false || stage != VK_SHADER_STAGE_VERTEX_BIT || variable.builtIn ||
+                        variable.location == UINT32_MAX) {
+                        continue;
+                    }
+                    vertexInputs.emplace_back(variable.location, 0, VertexInputFormat(type), 0);
+                    break;
+            }
+        }
+        std::ranges::sort(vertexInputs, {}, &VkVertexInputAttributeDescription::location);
+    }
+
+  public:
+    shaderReflection() = default;
+    shaderReflection(size_t codeSize, const uint32_t* pCode) { Reflect(codeSize, pCode); }
+    explicit shaderReflection(const char* filepath) { Reflect(filepath); }
+    // Getter
+    VkShaderStageFlagBits Stage() const { return stage; }
+    const std::vector<descriptorBinding>& DescriptorBindings() const { return descriptorBindings; }
+    const std::vector<VkPushConstantRange>& PushConstantRanges() const { return pushConstantRanges; }
+    // 顶点输入的binding和offset取决于顶点缓冲区的组织方式，均为0，由使用者填写
+    const std::vector<VkVertexInputAttributeDescription>& VertexInputs() const { return vertexInputs; }
+    // Non-const function
+    bool Reflect(size_t codeSize, const uint32_t* pCode) {
+        stage = VkShaderStageFlagBits(0);
+        descriptorBindings.clear();
+        pushConstantRanges.clear();
+        vertexInputs.clear();
+        bool succeeded = Parse(codeSize, pCode);
+        if (succeeded) { CollectVariables(); }
+        ids.clear();
+        ids.shrink_to_fit();
+        if (!succeeded) { outStream << std::format("[ shaderReflection ] ERROR\nFailed to parse the SPIR-V code!\n"); }
+        return succeeded;
+    }
+    bool Reflect(const char* filepath) {
+        mappedFile file(filepath);
+        if (!file) {
+            outStream << std::format("[ shaderReflection ] ERROR\nFailed to map the file: {}\n", filepath);
+            return false;
+        }
+        return Reflect(file.Size(), static_cast<const uint32_t*>(file.Data()));
+    }
+};
+
+/**
+ * 合并各阶段的反射结果得到管线布局
+ * 同一(set, binding)在多个阶段出现时合并着色器阶段，描述符类型或个数不一致时报错并保留先前的结果
+ * 反射无法区分动态与非动态缓冲区、无法确定运行时数组的大小，可在CreateLayouts()前通过Binding(...)修改
+ */
+class reflectedLayout {
+    std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;
+    std::vector<VkPushConstantRange> pushConstantRanges;
+
+  public:
+    struct layouts {
+        std::vector<std::shared_ptr<const descriptorSetLayout>> setLayouts;
+        std::shared_ptr<const vulkan::pipelineLayout> pipelineLayout;
+    };
+    reflectedLayout() = default;
+    reflectedLayout(std::initializer_list<std::reference_wrapper<const shaderReflection>> reflections) {
+        for (auto& i : reflections) { Merge(i); }
+    }
+    // Getter
+    const std::vector<VkPushConstantRange>& PushConstantRanges() const { return pushConstantRanges; }
+    // Non-const function
+    VkDescriptorSetLayoutBinding* Binding(uint32_t set, uint32_t binding) {
+        if (auto iterator_set = sets.find(set); iterator_set != sets.end()) {
+            if (auto iterator = iterator_set->second.find(binding); iterator != iterator_set->second.end()) {
+                return &iterator->second;
+            }
+        }
+        return nullptr;
+    }
+    reflectedLayout& Merge(const shaderReflection& reflection) {
+        for (auto& [set, binding] : reflection.DescriptorBindings()) {
+            auto [iterator, inserted] = sets[set].try_emplace(binding.binding, binding);
+            if (inserted) { continue; }
+            VkDescriptorSetLayoutBinding& existing = iterator->second;
+            // 动态缓冲区可能已由Binding(...)修改过，视作与对应的非动态类型相同
+            auto Normalize = [](VkDescriptorType type) {
+                if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) { return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; }
+                if (type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) { return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; }
+                return type;
+            };
+            if (false || Normalize(existing.descriptorType) != Normalize(binding.descriptorType) ||
+                existing.descriptorCount != binding.descriptorCount) {
+                outStream << std::format(
+                    "[ reflectedLayout ] ERROR\nConflicting descriptor at set {}, binding {}!\n", set, binding.binding
+                );
+                continue;
+            }
+            existing.stageFlags |= binding.stageFlags;
+        }
+        for (auto& range : reflection.PushConstantRanges()) {
+            auto iterator = std::ranges::find_if(pushConstantRanges, [&](const VkPushConstantRange& i) {
+                return i.offset == range.offset && i.size == range.size;
+            });
+            if (iterator == pushConstantRanges.end()) { pushConstantRanges.push_back(range); }
+            else { iterator->stageFlags |= range.stageFlags; }
+        }
+        return *this;
+    }
+    // 经layoutCache创建布局，内容相同的布局被共享，set序号不连续时以空布局填充，失败时pipelineLayout为空
+    layouts CreateLayouts() const {
+        layouts layouts;
+        uint32_t setCount = sets.empty() ? 0 : sets.rbegin()->first + 1;
+        std::vector<VkDescriptorSetLayout> handles(setCount);
+        for (uint32_t i = 0; i < setCount; i++) {
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+            if (auto iterator = sets.find(i); iterator != sets.end()) {
+                for (auto& [binding, layoutBinding] : iterator->second) { bindings.push_back(layoutBinding); }
+            }
+            auto pSetLayout =
+                layoutCache::Get().DescriptorSetLayout(arrayRef<const VkDescriptorSetLayoutBinding>(bindings));
+            if (!pSetLayout) { return {}; }
+            handles[i] = *pSetLayout;
+            layouts.setLayouts.push_back(std::move(pSetLayout));
+        }
+        layouts.pipelineLayout = layoutCache::Get().PipelineLayout(
+            arrayRef<const VkDescriptorSetLayout>(handles), arrayRef<const VkPushConstantRange>(pushConstantRanges)
+        );
+        return layouts;
+    }
+};
+}  // namespace vulkan
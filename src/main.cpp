@@ -1,5 +1,8 @@
 #include "EasyVulkan.hpp"
 #include "GlfwGeneral.hpp"
+#ifdef EMBEDDED_SHADERS
+#include "EmbeddedShaders.h"
+#endif
 
 using namespace vulkan;
 
@@ -8,9 +11,9 @@ struct vertex {
     glm::vec4 color;
 };
 
-pipelineLayout pipelineLayout_triangle;
+// 描述符集布局和管线布局由layoutCache共享
+reflectedLayout::layouts layouts_triangle;
 pipeline pipeline_triangle;
-descriptorSetLayout descriptorSetLayout_triangle;
 
 /**
  * 定义一个静态变量存储easyVulkan::CreateRpwf_Screen()返回值，确保只创建一次
@@ -22,68 +25,66 @@ const auto& RenderPassAndFramebuffers() {
 }
 
 void CreateLayout() {
-    VkDescriptorSetLayoutBinding descriptorSetLayoutBinding_trianglePosition = {
-        .binding = 0,                                         // 描述符被绑定到0号binding
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,  // 类型为uniform缓冲区
-        .descriptorCount = 1,                                 // 个数是1个
-        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT              // 在顶点着色器阶段读取uniform缓冲区
-    };
-    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo_triangle = {
-        .bindingCount = 1, .pBindings = &descriptorSetLayoutBinding_trianglePosition
-    };
-    descriptorSetLayout_triangle.Create(descriptorSetLayoutCreateInfo_triangle);
-
-    // VkPushConstantRange pushConstantRange = {
-    //     VK_SHADER_STAGE_VERTEX_BIT,
-    //     0,
-    //     24,
-    // };
-
-    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{// .pushConstantRangeCount = 1,
-                                                        // .pPushConstantRanges = &pushConstantRange,
-                                                        .setLayoutCount = 1,
-                                                        .pSetLayouts = descriptorSetLayout_triangle.Address()
-    };
-    pipelineLayout_triangle.Create(pipelineLayoutCreateInfo);
+    // 由着色器反射得到描述符绑定和push constant范围，与GLSL中的声明保持一致
+#ifdef EMBEDDED_SHADERS
+    shaderReflection vert(sizeof embeddedShaders::UniformBuffer_vert, embeddedShaders::UniformBuffer_vert);
+    shaderReflection frag(sizeof embeddedShaders::VertexBuffer_frag, embeddedShaders::VertexBuffer_frag);
+#else
+    shaderReflection vert("../shader/UniformBuffer.vert.spv");
+    shaderReflection frag("../shader/VertexBuffer.frag.spv");
+#endif
+    reflectedLayout layout = {vert, frag};
+    // 反射无法区分动态uniform缓冲区，每帧的数据以动态偏移指定
+    if (auto pBinding = layout.Binding(0, 0)) { pBinding->descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; }
+    layouts_triangle = layout.CreateLayouts();
+
+    auto Destroy = [] { layouts_triangle = {}; };
+    graphicsBase::Base().AddCallback_DestroyDevice(Destroy);
 }
 
 void CreatePipeline() {
-    static shaderModule vert("../shader/UniformBuffer.vert.spv");
-    static shaderModule frag("../shader/VertexBuffer.frag.spv");
-    static VkPipelineShaderStageCreateInfo shaderStageCreateInfos_triangles[2] = {
-        vert.StageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT),
-        frag.StageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT),
-    };
-    auto Create = [] {
-        graphicsPipelineCreateInfoPack pipelineCiPack;
-        pipelineCiPack.createInfo.layout = pipelineLayout_triangle;
-        pipelineCiPack.createInfo.renderPass = RenderPassAndFramebuffers().renderPass;
-        pipelineCiPack.inputAssemblyStateCi.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        // 数据来自0号顶点缓冲区，逐顶点输入
-        pipelineCiPack.vertexInputBindings.emplace_back(0, sizeof(vertex), VK_VERTEX_INPUT_RATE_VERTEX);
-        /*
-         * location=0,对应 “layout(location = 0) in”
-         * binding=0,表还数据来自0号顶点缓冲区
-         * vec3对应VK_FORMAT_R32G32B32A32_SFLOAT，用offsetof计算color在vertex中的起始位置
-         */
-        pipelineCiPack.vertexInputAttributes.emplace_back(0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(vertex, position));
-        pipelineCiPack.vertexInputAttributes.emplace_back(1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(vertex, color));
-        pipelineCiPack.viewports.emplace_back(
-            0.f, 0.f, static_cast<float>(windowSize.width), static_cast<float>(windowSize.height), 0.f, 1.f
-        );
-        pipelineCiPack.scissors.emplace_back(VkOffset2D{}, windowSize);
-        pipelineCiPack.multisampleStateCi.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-        pipelineCiPack.colorBlendAttachmentStates.push_back({.colorWriteMask = 0b1111});
-        pipelineCiPack.UpdateAllArrays();
-        pipelineCiPack.createInfo.stageCount = 2;
-        pipelineCiPack.createInfo.pStages = shaderStageCreateInfos_triangles;
-        pipeline_triangle.Create(pipelineCiPack);
-    };
+    // 着色器模块由缓存共享，管线创建完后即可释放
+#ifdef EMBEDDED_SHADERS
+    // 使用构建时编译并内嵌的SPIR-V，不读取文件
+    auto vert = shaderModuleCache::Get().Load(
+        sizeof embeddedShaders::UniformBuffer_vert, embeddedShaders::UniformBuffer_vert
+    );
+    auto frag = shaderModuleCache::Get().Load(
+        sizeof embeddedShaders::VertexBuffer_frag, embeddedShaders::VertexBuffer_frag
+    );
+#else
+    auto vert = shaderModuleCache::Get().Load("../shader/UniformBuffer.vert.spv");
+    auto frag = shaderModuleCache::Get().Load("../shader/VertexBuffer.frag.spv");
+#endif
+    if (!vert || !frag) { return; }
+
+    graphicsPipelineCreateInfoPack pipelineCiPack;
+    pipelineCiPack.createInfo.layout = *layouts_triangle.pipelineLayout;
+    pipelineCiPack.createInfo.renderPass = RenderPassAndFramebuffers().renderPass;
+    pipelineCiPack.inputAssemblyStateCi.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    // 数据来自0号顶点缓冲区，逐顶点输入
+    pipelineCiPack.vertexInputBindings.emplace_back(0, sizeof(vertex), VK_VERTEX_INPUT_RATE_VERTEX);
+    /*
+     * location=0,对应 “layout(location = 0) in”
+     * binding=0,表还数据来自0号顶点缓冲区
+     * vec3对应VK_FORMAT_R32G32B32A32_SFLOAT，用offsetof计算color在vertex中的起始位置
+     */
+    pipelineCiPack.vertexInputAttributes.emplace_back(0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(vertex, position));
+    pipelineCiPack.vertexInputAttributes.emplace_back(1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(vertex, color));
+    // 视口和裁剪范围为动态状态，由renderPass.CmdBegin(...)每帧设置，窗口大小改变时无需重建管线
+    pipelineCiPack.multisampleStateCi.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    pipelineCiPack.colorBlendAttachmentStates.push_back({.colorWriteMask = 0b1111});
+    pipelineCiPack.shaderStages.push_back(vert->StageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT));
+    pipelineCiPack.shaderStages.push_back(frag->StageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT));
+    pipelineCiPack.UpdateAllArrays();
+    pipeline_triangle.Create(pipelineCiPack);
+
     auto Destroy = [] { pipeline_triangle.~pipeline(); };
-    graphicsBase::Base().AddCallback_CreateSwapchain(Create);
-    graphicsBase::Base().AddCallback_DestroySwapchain(Destroy);
+    graphicsBase::Base().AddCallback_DestroyDevice(Destroy);
 
-    Create();
+    vert.reset();
+    frag.reset();
+    shaderModuleCache::Get().ReleaseUnused();
 }
 
 int main() {
@@ -98,8 +99,10 @@ int main() {
     glm::vec2 uniform_positions[] = {
         {.0f, .0f}, {}, {-.5f, .0f}, {}, {.5f, .0f}, {},
     };
-    uniformBuffer uniformBuffer(sizeof uniform_positions);
-    uniformBuffer.TransferData(uniform_positions);
+    // 每帧的uniform数据写入该帧独占的段，避免与仍在执行的前一帧竞争
+    frameRingBuffer frameRingBuffer(
+        uniformBuffer::CalculateAlignedSize(sizeof uniform_positions), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+    );
 
     vertex vertices[] = {
         {{.0f, -.5f}, {1, 0, 0, 1}},
@@ -107,24 +110,28 @@ int main() {
         {{.5f, .5f}, {0, 0, 1, 1}},
     };
     vertexBuffer vertexBuffer(sizeof vertices);
-    vertexBuffer.TransferData(vertices);
+    // 所有静态数据记录在同一批次中，只提交一次
+    uploadBatch uploadBatch;
+    if (vertexBuffer.TransferData(uploadBatch, vertices)) { return -1; }
+    uploadToken uploadToken;
+    if (uploadBatch.Submit(uploadToken)) { return -1; }
 
     // 创建描述符集
-    VkDescriptorPoolSize descriptorPoolSizes[] = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1}};
+    VkDescriptorPoolSize descriptorPoolSizes[] = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1}};
     descriptorPool descriptorPool(1, arrayRef<const VkDescriptorPoolSize>(descriptorPoolSizes));
     // 分配描述符集
     descriptorSet descriptorSet_trianglePosition;
     descriptorPool.AllocateSets(
-        arrayRef(descriptorSet_trianglePosition), arrayRef<const descriptorSetLayout>(descriptorSetLayout_triangle)
+        arrayRef(descriptorSet_trianglePosition), arrayRef<const descriptorSetLayout>(*layouts_triangle.setLayouts[0])
     );
-    // 将uniform缓冲区信息写入描述符集
+    // 将uniform缓冲区信息写入描述符集，实际偏移在绑定时以动态偏移给出
     VkDescriptorBufferInfo bufferInfo = {
-        .buffer = static_cast<VkBuffer>(uniformBuffer),
+        .buffer = static_cast<VkBuffer>(frameRingBuffer),
         .offset = 0,
         .range = sizeof uniform_positions,
     };
     descriptorSet_trianglePosition.Write(
-        arrayRef<const VkDescriptorBufferInfo>(bufferInfo), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+        arrayRef<const VkDescriptorBufferInfo>(bufferInfo), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
     );
 
     /**
@@ -137,25 +144,38 @@ int main() {
     struct PerFrame {
         fence frameFence{VK_FENCE_CREATE_SIGNALED_BIT};  // 确保每个帧在第一次提交时不会被阻塞
         semaphore semaphore_imageIsAvailable;
-        commandBuffer commandBuffer;
     };
     std::array<PerFrame, MAX_FRAMES_IN_FLIGHT> perFrame;
     std::vector<semaphore> semaphore_renderingIsOvers(graphicsBase::Base().SwapchainImageCount());
 
-    commandPool commandPool(
-        graphicsBase::Base().QueueFamilyIndex_Graphics(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
-    );
-    for (auto& frame : perFrame) { commandPool.AllocateBuffers(arrayRef(frame.commandBuffer)); }
+    // 每帧一个瞬态命令池，帧栅栏触发后整池重置，不再逐个重置命令缓冲区
+    frameContext frameContext(graphicsBase::Base().QueueFamilyIndex_Graphics());
     uint32_t currentFrame = 0;
 
+    // 首帧使用顶点缓冲区前等待上传完成
+    uploadToken.Wait();
+
     // render loop
     while (!glfwWindowShouldClose(pWindow)) {
         while (glfwGetWindowAttrib(pWindow, GLFW_ICONIFIED)) glfwWaitEvents();
 
-        const auto& [frameFence, semaphore_imageIsAvailable, commandBuffer] = perFrame[currentFrame];
+        const auto& [frameFence, semaphore_imageIsAvailable] = perFrame[currentFrame];
 
         // 当前帧的渲染命令不会在前一帧执行完之前开始，因此等待栅栏
         frameFence.WaitAndReset();
+        // 栅栏已触发，回收该帧上次使用的命令缓冲区
+        frameContext.BeginFrame(currentFrame);
+        const commandBuffer* pCommandBuffer = frameContext.AcquireCommandBuffer();
+        // 分配失败时结束程序：帧栅栏已被重置，跳过该帧会使下次等待该栅栏时永远阻塞
+        if (!pCommandBuffer) {
+            TerminateWindow();
+            return -1;
+        }
+        const commandBuffer& commandBuffer = *pCommandBuffer;
+        // 栅栏已触发，回收该帧上次使用的段
+        frameRingBuffer.BeginFrame(currentFrame);
+        std::optional<VkDeviceSize> uniformOffset = frameRingBuffer.Uniform(uniform_positions);
+        frameRingBuffer.Flush();
 
         // 获取下一帧要渲染的交换链图像索引
         graphicsBase::Base().SwapImage(semaphore_imageIsAvailable);
@@ -168,26 +188,30 @@ int main() {
             commandBuffer, framebuffers[imageIndex], {{}, windowSize}, arrayRef<const VkClearValue>(clearColor)
         );
 
+        // 经由编码器录制绑定命令，与已绑定状态相同的命令会被跳过
+        // 渲染通道开始时已设置了视口和裁剪范围，编码器在此之后创建，不记录此前的状态
+        commandEncoder encoder(commandBuffer);
+
         // 绑定顶点缓冲区
-        VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffer.Address(), &offset);
+        encoder.BindVertexBuffer(0, *vertexBuffer.Address());
 
         // 绑定图形管线并绘制三角形
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_triangle);
+        encoder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_triangle);
 
         // 推送常量数据到顶点着色器
-        // vkCmdPushConstants(
-        //     commandBuffer, pipelineLayout_triangle, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof pushConstants,
-        //     pushConstants
+        // encoder.PushConstants(
+        //     *layouts_triangle.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof pushConstants, pushConstants
         // );
 
-        // 绑定描述符集
-        vkCmdBindDescriptorSets(
-            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_triangle, 0, 1,
-            descriptorSet_trianglePosition.Address(), 0, nullptr
-        );
-
-        vkCmdDraw(commandBuffer, 3, 3, 0, 0);
+        // 绑定描述符集，uniform数据未能写入当前帧的段时不绘制，以免读到其他帧的数据
+        if (uniformOffset) {
+            auto dynamicOffset = static_cast<uint32_t>(*uniformOffset);
+            encoder.BindDescriptorSet(
+                VK_PIPELINE_BIND_POINT_GRAPHICS, *layouts_triangle.pipelineLayout, 0, descriptorSet_trianglePosition,
+                arrayRef<const uint32_t>(dynamicOffset)
+            );
+            encoder.Draw(3, 3);
+        }
 
         // 结束渲染通道
         renderPass.CmdEnd(commandBuffer);
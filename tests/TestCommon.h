@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdio>
+
+// 检查失败时打印表达式和位置并计数，main()以TestResult()作为返回值
+inline int testFailureCount = 0;
+
+#define CHECK(expression)                                                               \
+    do {                                                                                \
+        if (!(expression)) {                                                            \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expression);  \
+            testFailureCount++;                                                         \
+        }                                                                               \
+    } while (false)
+
+inline int TestResult() {
+    if (testFailureCount) { std::printf("%d check(s) failed\n", testFailureCount); }
+    return testFailureCount ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+// graphicsBase::SelectQueueFamilies(...)只读取队列簇属性，以伪造的队列簇布局验证各队列簇的选择
+#include "TestCommon.h"
+#include "VKBase.h"
+
+using namespace vulkan;
+
+namespace {
+constexpr VkQueueFlags G = VK_QUEUE_GRAPHICS_BIT;
+constexpr VkQueueFlags C = VK_QUEUE_COMPUTE_BIT;
+constexpr VkQueueFlags T = VK_QUEUE_TRANSFER_BIT;
+constexpr VkQueueFlags S = VK_QUEUE_SPARSE_BINDING_BIT;
+
+template <size_t count>
+graphicsBase::queueFamilySelection Select(
+    const VkQueueFlags (&flags)[count], std::initializer_list<VkBool32> supportPresentation = {}
+) {
+    std::vector<VkQueueFamilyProperties> properties(count);
+    for (size_t i = 0; i < count; i++) { properties[i] = {.queueFlags = flags[i], .queueCount = 1}; }
+    std::vector<VkBool32> presentation(supportPresentation);
+    return graphicsBase::SelectQueueFamilies(
+        arrayRef<const VkQueueFamilyProperties>(properties), arrayRef<const VkBool32>(presentation)
+    );
+}
+
+// 只有一个全能队列簇：所有用途共用之
+void TestSingleFamily() {
+    auto selection = Select({G | C | T}, {VK_TRUE});
+    CHECK(selection.graphics == 0);
+    CHECK(selection.presentation == 0);
+    CHECK(selection.compute == 0);
+    CHECK(selection.transfer == 0);
+}
+
+// 常见的独立显卡布局：全能队列簇、仅传输的队列簇（DMA）、不支持图形的计算队列簇
+void TestDedicatedFamilies() {
+    auto selection = Select({G | C | T | S, T | S, C | T | S}, {VK_TRUE, VK_FALSE, VK_FALSE});
+    CHECK(selection.graphics == 0);
+    CHECK(selection.presentation == 0);
+    CHECK(selection.compute == 2);
+    CHECK(selection.transfer == 1);
+}
+
+// 仅有异步计算队列簇时，传输不会落到计算队列簇上，而是退回图形队列簇
+void TestComputeFamilyIsNotUsedForTransfer() {
+    auto selection = Select({G | C | T, C | T}, {VK_TRUE, VK_FALSE});
+    CHECK(selection.compute == 1);
+    CHECK(selection.transfer == 0);
+}
+
+// 有多个候选时各取第一个
+void TestFirstCandidateWins() {
+    auto selection = Select({G | C | T, T, C | T, T, C | T});
+    CHECK(selection.compute == 2);
+    CHECK(selection.transfer == 1);
+}
+
+// 图形队列簇须支持呈现，跳过不支持呈现的全能队列簇
+void TestGraphicsFamilyMustSupportPresentation() {
+    auto selection = Select({G | C | T, T, G | C | T}, {VK_FALSE, VK_FALSE, VK_TRUE});
+    CHECK(selection.graphics == 2);
+    CHECK(selection.presentation == 2);
+    CHECK(selection.transfer == 1);
+}
+
+// 图形队列簇须同时支持计算
+void TestGraphicsFamilyMustSupportCompute() {
+    auto selection = Select({G | T, G | C | T});
+    CHECK(selection.graphics == 1);
+}
+
+// 不需要呈现时不选择呈现队列簇
+void TestNoPresentation() {
+    auto selection = Select({G | C | T});
+    CHECK(selection.graphics == 0);
+    CHECK(selection.presentation == VK_QUEUE_FAMILY_IGNORED);
+}
+
+// 没有合适的图形队列簇时，什么都不选
+void TestNoGraphicsFamily() {
+    auto selection = Select({C | T, T}, {VK_TRUE, VK_TRUE});
+    CHECK(selection.graphics == VK_QUEUE_FAMILY_IGNORED);
+    CHECK(selection.presentation == VK_QUEUE_FAMILY_IGNORED);
+    CHECK(selection.compute == VK_QUEUE_FAMILY_IGNORED);
+    CHECK(selection.transfer == VK_QUEUE_FAMILY_IGNORED);
+}
+}  // namespace
+
+int main() {
+    TestSingleFamily();
+    TestDedicatedFamilies();
+    TestComputeFamilyIsNotUsedForTransfer();
+    TestFirstCandidateWins();
+    TestGraphicsFamilyMustSupportPresentation();
+    TestGraphicsFamilyMustSupportCompute();
+    TestNoPresentation();
+    TestNoGraphicsFamily();
+    return TestResult();
+}
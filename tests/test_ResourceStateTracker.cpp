@@ -0,0 +1,149 @@
+// resourceStateTracker只在CPU侧计算屏障，不调用Flush(...)即无需设备，以Batch()检查所产生的最少屏障
+#include "TestCommon.h"
+#include "VKBase+.h"
+
+using namespace vulkan;
+
+namespace {
+// 跟踪器只以句柄作为键，不解引用
+const VkImage image = VkImage(uintptr_t(0x10));
+const VkBuffer buffer = VkBuffer(uintptr_t(0x20));
+
+// 首次使用未定义布局的图像：一个布局转换，无需等待任何阶段
+void TestInitialTransition() {
+    resourceStateTracker tracker;
+    tracker.TrackImage(image, VK_IMAGE_ASPECT_COLOR_BIT);
+    tracker.UseImage(
+        image, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    );
+    const pipelineBarrierBatch& batch = tracker.Batch();
+    CHECK(batch.SrcStages() == 0);
+    CHECK(batch.DstStages() == VK_PIPELINE_STAGE_TRANSFER_BIT);
+    CHECK(batch.BufferMemoryBarriers().empty());
+    CHECK(batch.ImageMemoryBarriers().size() == 1);
+    if (batch.ImageMemoryBarriers().size() != 1) { return; }
+    const VkImageMemoryBarrier& barrier = batch.ImageMemoryBarriers()[0];
+    CHECK(barrier.srcAccessMask == 0);
+    CHECK(barrier.dstAccessMask == VK_ACCESS_TRANSFER_WRITE_BIT);
+    CHECK(barrier.oldLayout == VK_IMAGE_LAYOUT_UNDEFINED);
+    CHECK(barrier.newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    CHECK(barrier.srcQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED);
+    CHECK(barrier.dstQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED);
+}
+
+// 缓冲区的首次写入无需屏障，此后的读取须等待该写入
+void TestBufferReadAfterWrite() {
+    resourceStateTracker tracker;
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    CHECK(tracker.Batch().Empty());
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+    const pipelineBarrierBatch& batch = tracker.Batch();
+    CHECK(batch.SrcStages() == VK_PIPELINE_STAGE_TRANSFER_BIT);
+    CHECK(batch.DstStages() == VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    CHECK(batch.BufferMemoryBarriers().size() == 1);
+    if (batch.BufferMemoryBarriers().size() != 1) { return; }
+    const VkBufferMemoryBarrier& barrier = batch.BufferMemoryBarriers()[0];
+    CHECK(barrier.srcAccessMask == VK_ACCESS_TRANSFER_WRITE_BIT);
+    CHECK(barrier.dstAccessMask == VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+    CHECK(barrier.buffer == buffer);
+    CHECK(barrier.size == VK_WHOLE_SIZE);
+}
+
+// 读后读：已同步的阶段和访问类型不再产生屏障，新的读取阶段只需等待最近一次写入
+void TestReadAfterRead() {
+    resourceStateTracker tracker;
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT);
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT);
+    CHECK(tracker.Batch().BufferMemoryBarriers().size() == 1);
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT);
+    const pipelineBarrierBatch& batch = tracker.Batch();
+    CHECK(batch.BufferMemoryBarriers().size() == 2);
+    if (batch.BufferMemoryBarriers().size() != 2) { return; }
+    CHECK(batch.BufferMemoryBarriers()[1].srcAccessMask == VK_ACCESS_TRANSFER_WRITE_BIT);
+    CHECK(batch.SrcStages() == VK_PIPELINE_STAGE_TRANSFER_BIT);
+    CHECK(batch.DstStages() == (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT));
+}
+
+// 写后读：写入须等待此前的读取，以及读取之前的写入
+void TestWriteAfterRead() {
+    resourceStateTracker tracker;
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    const pipelineBarrierBatch& batch = tracker.Batch();
+    CHECK(batch.SrcStages() == (VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT));
+    CHECK(batch.BufferMemoryBarriers().size() == 2);
+    if (batch.BufferMemoryBarriers().size() != 2) { return; }
+    CHECK(batch.BufferMemoryBarriers()[1].srcAccessMask == VK_ACCESS_TRANSFER_WRITE_BIT);
+    CHECK(batch.BufferMemoryBarriers()[1].dstAccessMask == VK_ACCESS_SHADER_WRITE_BIT);
+    const resourceStateTracker::accessState* pState = tracker.BufferState(buffer);
+    CHECK(pState && pState->writeStages == VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT && !pState->readStages);
+}
+
+// 状态相同的子资源合为一个屏障：相邻图层在同一mip级别内合并，图层范围相同的相邻mip级别由批次合并
+void TestWholeImageMerges() {
+    resourceStateTracker tracker;
+    tracker.TrackImage(image, VK_IMAGE_ASPECT_COLOR_BIT, 4, 2);
+    tracker.UseImage(
+        image, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    );
+    const pipelineBarrierBatch& batch = tracker.Batch();
+    CHECK(batch.ImageMemoryBarriers().size() == 1);
+    if (batch.ImageMemoryBarriers().size() != 1) { return; }
+    const VkImageSubresourceRange& range = batch.ImageMemoryBarriers()[0].subresourceRange;
+    CHECK(range.baseMipLevel == 0 && range.levelCount == 4);
+    CHECK(range.baseArrayLayer == 0 && range.layerCount == 2);
+}
+
+// 只使用部分子资源时，只有这些子资源产生屏障并改变状态；状态不同的子资源各用一个屏障
+void TestPartialRanges() {
+    resourceStateTracker tracker;
+    tracker.TrackImage(image, VK_IMAGE_ASPECT_COLOR_BIT, 2, 2, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    tracker.UseImage(
+        image, {VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, 0, 1}, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+    );
+    CHECK(tracker.Batch().ImageMemoryBarriers().size() == 1);
+    CHECK(tracker.ImageState(image, 1, 0)->layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    CHECK(tracker.ImageState(image, 1, 1)->layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    CHECK(tracker.ImageState(image, 0, 0)->layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    // 此后使用整个图像：mip 1的图层0与其余子资源的旧布局不同，mip 1被拆为两个屏障，mip 0的两个图层合为一个
+    tracker.UseImage(
+        image, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    );
+    const std::vector<VkImageMemoryBarrier>& barriers = tracker.Batch().ImageMemoryBarriers();
+    CHECK(barriers.size() == 4);
+    if (barriers.size() != 4) { return; }
+    CHECK(barriers[1].subresourceRange.baseMipLevel == 0 && barriers[1].subresourceRange.layerCount == 2);
+    CHECK(barriers[2].oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    CHECK(barriers[2].subresourceRange.baseArrayLayer == 0 && barriers[2].subresourceRange.layerCount == 1);
+    CHECK(barriers[3].oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    CHECK(barriers[3].subresourceRange.baseArrayLayer == 1 && barriers[3].subresourceRange.layerCount == 1);
+}
+
+// 使用时指定的队列族与记录的不同时，产生所有权转移的获取屏障
+void TestQueueFamilyOwnershipTransfer() {
+    resourceStateTracker tracker;
+    tracker.TrackBuffer(buffer, 1);
+    tracker.UseBuffer(buffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, 0);
+    const pipelineBarrierBatch& batch = tracker.Batch();
+    CHECK(batch.BufferMemoryBarriers().size() == 1);
+    if (batch.BufferMemoryBarriers().size() != 1) { return; }
+    CHECK(batch.BufferMemoryBarriers()[0].srcQueueFamilyIndex == 1);
+    CHECK(batch.BufferMemoryBarriers()[0].dstQueueFamilyIndex == 0);
+    CHECK(tracker.BufferState(buffer)->queueFamilyIndex == 0);
+}
+}  // namespace
+
+int main() {
+    TestInitialTransition();
+    TestBufferReadAfterWrite();
+    TestReadAfterRead();
+    TestWriteAfterRead();
+    TestWholeImageMerges();
+    TestPartialRanges();
+    TestQueueFamilyOwnershipTransfer();
+    return TestResult();
+}